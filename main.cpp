@@ -149,6 +149,7 @@ int main(int argc, char *argv[]) {
     settings.mPrefix = args.mPrefix;
     settings.mExportAnimation = args.mExportAnimation;
     settings.mExportGeometry = args.mExportGeometry;
+    settings.mThreadCount = args.mThreadCount;
 
     bool hasError = false;
 
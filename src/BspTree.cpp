@@ -0,0 +1,357 @@
+#include "BspTree.h"
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <math.h>
+
+// distance from a plane that still counts as being on it, relative to the size of the level
+#define BSP_PLANE_TOLERANCE     0.00001f
+// number of faces tried as the splitting plane for each node
+#define BSP_SPLIT_CANDIDATES    16
+// how much worse cutting a face is than an unbalanced tree
+#define BSP_SPLIT_COST          8
+
+struct BspVertex {
+    // index in the source mesh or -1 for vertices made by splitting a face
+    int mSourceIndex;
+    aiVector3D mPosition;
+    aiVector3D mNormal;
+    aiVector3D mUV;
+    aiColor4D mColor;
+};
+
+struct BspPolygon {
+    unsigned mMeshIndex;
+    aiVector3D mNormal;
+    float mDistance;
+    std::vector<BspVertex> mVertices;
+};
+
+enum class BspSide {
+    Coplanar,
+    Front,
+    Back,
+    Spanning,
+};
+
+BspVertex lerpBspVertex(const BspVertex& from, const BspVertex& to, float lerp) {
+    BspVertex result;
+    result.mSourceIndex = -1;
+    result.mPosition = from.mPosition + (to.mPosition - from.mPosition) * lerp;
+    result.mNormal = from.mNormal + (to.mNormal - from.mNormal) * lerp;
+    result.mUV = from.mUV + (to.mUV - from.mUV) * lerp;
+    result.mColor.r = from.mColor.r + (to.mColor.r - from.mColor.r) * lerp;
+    result.mColor.g = from.mColor.g + (to.mColor.g - from.mColor.g) * lerp;
+    result.mColor.b = from.mColor.b + (to.mColor.b - from.mColor.b) * lerp;
+    result.mColor.a = from.mColor.a + (to.mColor.a - from.mColor.a) * lerp;
+
+    if (result.mNormal.SquareLength() > 0.0f) {
+        result.mNormal.Normalize();
+    }
+
+    return result;
+}
+
+BspSide classifyPolygon(const BspPolygon& polygon, const aiVector3D& normal, float distance, float tolerance) {
+    bool hasFront = false;
+    bool hasBack = false;
+
+    for (auto& vertex : polygon.mVertices) {
+        float offset = vertex.mPosition * normal - distance;
+
+        if (offset > tolerance) {
+            hasFront = true;
+        } else if (offset < -tolerance) {
+            hasBack = true;
+        }
+    }
+
+    if (hasFront && hasBack) {
+        return BspSide::Spanning;
+    } else if (hasFront) {
+        return BspSide::Front;
+    } else if (hasBack) {
+        return BspSide::Back;
+    }
+
+    return BspSide::Coplanar;
+}
+
+void splitPolygon(const BspPolygon& polygon, const aiVector3D& normal, float distance, float tolerance, BspPolygon& front, BspPolygon& back) {
+    front.mMeshIndex = back.mMeshIndex = polygon.mMeshIndex;
+    front.mNormal = back.mNormal = polygon.mNormal;
+    front.mDistance = back.mDistance = polygon.mDistance;
+
+    for (unsigned i = 0; i < polygon.mVertices.size(); ++i) {
+        const BspVertex& current = polygon.mVertices[i];
+        const BspVertex& next = polygon.mVertices[(i + 1) % polygon.mVertices.size()];
+
+        float currentOffset = current.mPosition * normal - distance;
+        float nextOffset = next.mPosition * normal - distance;
+
+        if (currentOffset >= -tolerance) {
+            front.mVertices.push_back(current);
+        }
+
+        if (currentOffset <= tolerance) {
+            back.mVertices.push_back(current);
+        }
+
+        if ((currentOffset > tolerance && nextOffset < -tolerance) ||
+            (currentOffset < -tolerance && nextOffset > tolerance)) {
+            BspVertex cut = lerpBspVertex(current, next, currentOffset / (currentOffset - nextOffset));
+            front.mVertices.push_back(cut);
+            back.mVertices.push_back(cut);
+        }
+    }
+}
+
+unsigned chooseSplitter(const std::vector<BspPolygon>& polygons, float tolerance) {
+    unsigned step = std::max(1u, (unsigned)polygons.size() / BSP_SPLIT_CANDIDATES);
+    unsigned result = 0;
+    unsigned bestScore = ~0u;
+
+    for (unsigned candidate = 0; candidate < polygons.size(); candidate += step) {
+        unsigned frontCount = 0;
+        unsigned backCount = 0;
+        unsigned splitCount = 0;
+
+        for (auto& polygon : polygons) {
+            switch (classifyPolygon(polygon, polygons[candidate].mNormal, polygons[candidate].mDistance, tolerance)) {
+                case BspSide::Front:
+                    ++frontCount;
+                    break;
+                case BspSide::Back:
+                    ++backCount;
+                    break;
+                case BspSide::Spanning:
+                    ++splitCount;
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        unsigned score = splitCount * BSP_SPLIT_COST + (frontCount > backCount ? frontCount - backCount : backCount - frontCount);
+
+        if (score < bestScore) {
+            bestScore = score;
+            result = candidate;
+        }
+    }
+
+    return result;
+}
+
+aiMesh* buildBspMesh(const aiMesh* source, const std::vector<const BspPolygon*>& polygons) {
+    std::map<int, unsigned> sourceMapping;
+    std::vector<BspVertex> vertices;
+    std::vector<std::vector<unsigned>> faces;
+
+    for (auto polygon : polygons) {
+        std::vector<unsigned> indices;
+
+        for (auto& vertex : polygon->mVertices) {
+            if (vertex.mSourceIndex >= 0) {
+                auto existing = sourceMapping.find(vertex.mSourceIndex);
+
+                if (existing != sourceMapping.end()) {
+                    indices.push_back(existing->second);
+                    continue;
+                }
+
+                sourceMapping[vertex.mSourceIndex] = vertices.size();
+            }
+
+            indices.push_back(vertices.size());
+            vertices.push_back(vertex);
+        }
+
+        for (unsigned corner = 2; corner < indices.size(); ++corner) {
+            faces.push_back({indices[0], indices[corner - 1], indices[corner]});
+        }
+    }
+
+    aiMesh* result = new aiMesh();
+    result->mMaterialIndex = source->mMaterialIndex;
+    result->mMethod = source->mMethod;
+    result->mName = source->mName;
+
+    result->mNumVertices = vertices.size();
+    result->mVertices = new aiVector3D[result->mNumVertices];
+    if (source->mNormals) result->mNormals = new aiVector3D[result->mNumVertices];
+    if (source->mTextureCoords[0]) result->mTextureCoords[0] = new aiVector3D[result->mNumVertices];
+    if (source->mColors[0]) result->mColors[0] = new aiColor4D[result->mNumVertices];
+
+    for (unsigned i = 0; i < vertices.size(); ++i) {
+        result->mVertices[i] = vertices[i].mPosition;
+        if (result->mNormals) result->mNormals[i] = vertices[i].mNormal;
+        if (result->mTextureCoords[0]) result->mTextureCoords[0][i] = vertices[i].mUV;
+        if (result->mColors[0]) result->mColors[0][i] = vertices[i].mColor;
+    }
+
+    result->mNumFaces = faces.size();
+    result->mFaces = new aiFace[result->mNumFaces];
+
+    for (unsigned i = 0; i < faces.size(); ++i) {
+        result->mFaces[i].mNumIndices = 3;
+        result->mFaces[i].mIndices = new unsigned[3];
+        std::copy(faces[i].begin(), faces[i].end(), result->mFaces[i].mIndices);
+    }
+
+    return result;
+}
+
+int buildBspNode(const std::vector<aiMesh*>& meshes, std::vector<BspPolygon>& polygons, unsigned maxSplits, float tolerance, BspTree& result) {
+    if (polygons.empty()) {
+        return -1;
+    }
+
+    unsigned splitterIndex = chooseSplitter(polygons, tolerance);
+    BspPolygon splitter = polygons[splitterIndex];
+
+    std::vector<BspPolygon> front;
+    std::vector<BspPolygon> back;
+    // the splitter always stays in this node, even if rounding puts some of its
+    // points off its own plane, so each level of the tree makes progress
+    std::vector<const BspPolygon*> coplanar = {&polygons[splitterIndex]};
+
+    for (unsigned i = 0; i < polygons.size(); ++i) {
+        if (i == splitterIndex) {
+            continue;
+        }
+
+        const BspPolygon& polygon = polygons[i];
+
+        switch (classifyPolygon(polygon, splitter.mNormal, splitter.mDistance, tolerance)) {
+            case BspSide::Coplanar:
+                coplanar.push_back(&polygon);
+                break;
+            case BspSide::Front:
+                front.push_back(polygon);
+                break;
+            case BspSide::Back:
+                back.push_back(polygon);
+                break;
+            case BspSide::Spanning:
+                front.push_back(BspPolygon());
+                back.push_back(BspPolygon());
+                splitPolygon(polygon, splitter.mNormal, splitter.mDistance, tolerance, front.back(), back.back());
+                ++result.mSplitCount;
+                break;
+        }
+    }
+
+    if (result.mSplitCount > maxSplits) {
+        return -1;
+    }
+
+    int nodeIndex = result.mNodes.size();
+    result.mNodes.push_back(BspNode());
+    result.mNodes[nodeIndex].mNormal = splitter.mNormal;
+    result.mNodes[nodeIndex].mDistance = splitter.mDistance;
+
+    for (unsigned meshIndex = 0; meshIndex < meshes.size(); ++meshIndex) {
+        std::vector<const BspPolygon*> meshPolygons;
+
+        for (auto polygon : coplanar) {
+            if (polygon->mMeshIndex == meshIndex) {
+                meshPolygons.push_back(polygon);
+            }
+        }
+
+        if (meshPolygons.size()) {
+            result.mNodes[nodeIndex].mMeshes.push_back(buildBspMesh(meshes[meshIndex], meshPolygons));
+        }
+    }
+
+    // the polygons are copied into front and back so they can be freed before going deeper
+    polygons.clear();
+    polygons.shrink_to_fit();
+
+    int frontIndex = buildBspNode(meshes, front, maxSplits, tolerance, result);
+    int backIndex = buildBspNode(meshes, back, maxSplits, tolerance, result);
+
+    result.mNodes[nodeIndex].mFront = frontIndex;
+    result.mNodes[nodeIndex].mBack = backIndex;
+
+    return nodeIndex;
+}
+
+bool buildBspTree(const std::vector<aiMesh*>& meshes, unsigned maxSplits, BspTree& result) {
+    std::vector<BspPolygon> polygons;
+
+    for (unsigned meshIndex = 0; meshIndex < meshes.size(); ++meshIndex) {
+        aiMesh* mesh = meshes[meshIndex];
+
+        for (unsigned faceIndex = 0; faceIndex < mesh->mNumFaces; ++faceIndex) {
+            aiFace* face = &mesh->mFaces[faceIndex];
+
+            if (face->mNumIndices < 3) {
+                continue;
+            }
+
+            BspPolygon polygon;
+            polygon.mMeshIndex = meshIndex;
+
+            for (unsigned i = 0; i < face->mNumIndices; ++i) {
+                unsigned index = face->mIndices[i];
+
+                BspVertex vertex;
+                vertex.mSourceIndex = index;
+                vertex.mPosition = mesh->mVertices[index];
+                vertex.mNormal = mesh->mNormals ? mesh->mNormals[index] : aiVector3D();
+                vertex.mUV = mesh->mTextureCoords[0] ? mesh->mTextureCoords[0][index] : aiVector3D();
+                vertex.mColor = mesh->mColors[0] ? mesh->mColors[0][index] : aiColor4D();
+                polygon.mVertices.push_back(vertex);
+            }
+
+            const aiVector3D& a = polygon.mVertices[0].mPosition;
+            polygon.mNormal = (polygon.mVertices[1].mPosition - a) ^ (polygon.mVertices[2].mPosition - a);
+
+            // faces with no area are never drawn
+            if (polygon.mNormal.SquareLength() == 0.0f) {
+                continue;
+            }
+
+            polygon.mNormal.Normalize();
+            polygon.mDistance = polygon.mNormal * a;
+            polygons.push_back(polygon);
+        }
+    }
+
+    aiVector3D min(std::numeric_limits<float>::max());
+    aiVector3D max(-std::numeric_limits<float>::max());
+
+    for (auto& polygon : polygons) {
+        for (auto& vertex : polygon.mVertices) {
+            min.x = std::min(min.x, vertex.mPosition.x); min.y = std::min(min.y, vertex.mPosition.y); min.z = std::min(min.z, vertex.mPosition.z);
+            max.x = std::max(max.x, vertex.mPosition.x); max.y = std::max(max.y, vertex.mPosition.y); max.z = std::max(max.z, vertex.mPosition.z);
+        }
+    }
+
+    // rounding errors in the plane distance grow with how far the geometry is from the origin
+    float levelSize = 1.0f;
+
+    for (unsigned axis = 0; polygons.size() && axis < 3; ++axis) {
+        levelSize = std::max(levelSize, std::max(fabsf(min[axis]), fabsf(max[axis])));
+    }
+
+    result.mNodes.clear();
+    result.mSplitCount = 0;
+    buildBspNode(meshes, polygons, maxSplits, levelSize * BSP_PLANE_TOLERANCE, result);
+
+    if (result.mSplitCount > maxSplits) {
+        for (auto& node : result.mNodes) {
+            for (auto mesh : node.mMeshes) {
+                delete mesh;
+            }
+        }
+
+        result.mNodes.clear();
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,32 @@
+#ifndef _BSP_TREE_H
+#define _BSP_TREE_H
+
+#include <assimp/mesh.h>
+#include <vector>
+
+class BspNode {
+public:
+    // points p where mNormal * p == mDistance are on the plane of the node
+    aiVector3D mNormal;
+    float mDistance;
+    // index of the child node on each side of the plane or -1 if there isn't one
+    int mFront;
+    int mBack;
+    // the faces lying on the plane, one mesh for each source mesh
+    std::vector<aiMesh*> mMeshes;
+};
+
+class BspTree {
+public:
+    // the root is the first node
+    std::vector<BspNode> mNodes;
+    // number of faces that were cut in two by a node plane
+    unsigned mSplitCount;
+};
+
+// drawing the back side, the node, then the front side for each node starting at the root
+// draws faces back to front for a camera on the front side. Gives up and returns false
+// if more than maxSplits faces would be cut. Caller is responsible for freeing the new meshes
+bool buildBspTree(const std::vector<aiMesh*>& meshes, unsigned maxSplits, BspTree& result);
+
+#endif
@@ -1,6 +1,151 @@
 #include "Collision.h"
 
+#include <limits>
+#include <math.h>
+#include <algorithm>
+#include <unordered_map>
+#include <map>
+#include <iostream>
+
+float crossXZ(const aiVector3D& origin, const aiVector3D& a, const aiVector3D& b) {
+    return (a.x - origin.x) * (b.z - origin.z) - (a.z - origin.z) * (b.x - origin.x);
+}
+
+bool isBetweenXZ(const aiVector3D& from, const aiVector3D& to, const aiVector3D& point) {
+    return std::min(from.x, to.x) <= point.x && point.x <= std::max(from.x, to.x) &&
+        std::min(from.z, to.z) <= point.z && point.z <= std::max(from.z, to.z);
+}
+
+bool doSegmentsIntersectXZ(const aiVector3D& a0, const aiVector3D& a1, const aiVector3D& b0, const aiVector3D& b1) {
+    float d0 = crossXZ(b0, b1, a0);
+    float d1 = crossXZ(b0, b1, a1);
+    float d2 = crossXZ(a0, a1, b0);
+    float d3 = crossXZ(a0, a1, b1);
+
+    if (((d0 > 0.0f && d1 < 0.0f) || (d0 < 0.0f && d1 > 0.0f)) && ((d2 > 0.0f && d3 < 0.0f) || (d2 < 0.0f && d3 > 0.0f))) {
+        return true;
+    }
+
+    return (d0 == 0.0f && isBetweenXZ(b0, b1, a0)) ||
+        (d1 == 0.0f && isBetweenXZ(b0, b1, a1)) ||
+        (d2 == 0.0f && isBetweenXZ(a0, a1, b0)) ||
+        (d3 == 0.0f && isBetweenXZ(a0, a1, b1));
+}
+
+// like doSegmentsIntersectXZ but the segments have to pass through each other
+// touching at a point or running along each other doesn't count
+bool doSegmentsCrossXZ(const aiVector3D& a0, const aiVector3D& a1, const aiVector3D& b0, const aiVector3D& b1) {
+    float d0 = crossXZ(b0, b1, a0);
+    float d1 = crossXZ(b0, b1, a1);
+    float d2 = crossXZ(a0, a1, b0);
+    float d3 = crossXZ(a0, a1, b1);
+
+    return ((d0 > 0.00001f && d1 < -0.00001f) || (d0 < -0.00001f && d1 > 0.00001f)) &&
+        ((d2 > 0.00001f && d3 < -0.00001f) || (d2 < -0.00001f && d3 > 0.00001f));
+}
+
+// andrew's monotone chain, gives the hull counter clockwise in the xz plane
+void buildConvexHullXZ(std::vector<aiVector3D> points, std::vector<aiVector3D>& result) {
+    std::sort(points.begin(), points.end(), [](const aiVector3D& a, const aiVector3D& b) -> bool {
+        return a.x < b.x || (a.x == b.x && a.z < b.z);
+    });
+
+    result.clear();
+
+    if (points.size() < 3) {
+        result = points;
+        return;
+    }
+
+    std::vector<aiVector3D> hull(points.size() * 2);
+    unsigned hullSize = 0;
+
+    for (unsigned i = 0; i < points.size(); ++i) {
+        while (hullSize >= 2 && crossXZ(hull[hullSize - 2], hull[hullSize - 1], points[i]) <= 0.0f) {
+            --hullSize;
+        }
+        hull[hullSize++] = points[i];
+    }
+
+    unsigned lowerSize = hullSize + 1;
+
+    for (int i = (int)points.size() - 2; i >= 0; --i) {
+        while (hullSize >= lowerSize && crossXZ(hull[hullSize - 2], hull[hullSize - 1], points[i]) <= 0.0f) {
+            --hullSize;
+        }
+        hull[hullSize++] = points[i];
+    }
+
+    // the last point is the same as the first
+    result.insert(result.end(), hull.begin(), hull.begin() + hullSize - 1);
+}
+
+long long boundaryGridKey(int x, int z) {
+    return ((long long)(unsigned)x << 32) | (unsigned)z;
+}
+
+// follows the outline edges from vertex to vertex collecting every simple loop, vertices
+// without exactly two outline edges can't be part of a loop. returns the number of outline vertices
+unsigned walkBoundaryLoops(const std::vector<std::vector<unsigned>>& neighbors, std::vector<std::vector<unsigned>>& result) {
+    std::vector<bool> visited(neighbors.size(), false);
+    unsigned edgeVertexCount = 0;
+
+    for (unsigned start = 0; start < neighbors.size(); ++start) {
+        if (!neighbors[start].empty()) {
+            ++edgeVertexCount;
+        }
+
+        if (visited[start] || neighbors[start].size() != 2) {
+            continue;
+        }
+
+        std::vector<unsigned> loop;
+        unsigned previous = start;
+        unsigned current = neighbors[start][0];
+        bool isClosed = true;
+        visited[start] = true;
+        loop.push_back(start);
+
+        while (current != start) {
+            if (visited[current] || neighbors[current].size() != 2) {
+                isClosed = false;
+                break;
+            }
+
+            visited[current] = true;
+            loop.push_back(current);
+            unsigned next = neighbors[current][0] == previous ? neighbors[current][1] : neighbors[current][0];
+            previous = current;
+            current = next;
+        }
+
+        if (isClosed && loop.size() >= 3) {
+            result.push_back(loop);
+        }
+    }
+
+    return edgeVertexCount;
+}
+
+float loopAreaXZ(const std::vector<aiVector3D>& loop) {
+    float area = 0.0f;
+
+    for (unsigned i = 0; i < loop.size(); ++i) {
+        const aiVector3D& a = loop[i];
+        const aiVector3D& b = loop[(i + 1) % loop.size()];
+        area += a.x * b.z - b.x * a.z;
+    }
+
+    return area * 0.5f;
+}
+
 void extractMeshBoundary(aiMesh* mesh, const aiMatrix4x4& transform, std::vector<aiVector3D>& result) {
+    result.clear();
+
+    if (mesh->mNumVertices == 0) {
+        return;
+    }
+
     std::vector<aiVector3D> transformed;
 
     for (unsigned i = 0; i < mesh->mNumVertices; ++i) {
@@ -13,33 +158,598 @@ void extractMeshBoundary(aiMesh* mesh, const aiMatrix4x4& transform, std::vector
         minY = std::min(minY, transformed[i].y);
     }
 
+    // weld the bottom vertices so edges can be matched across faces
+    std::vector<int> bottomIndex(transformed.size(), -1);
+    std::vector<aiVector3D> bottomPoints;
+    std::unordered_map<long long, std::vector<unsigned>> weldGrid;
+
     for (unsigned i = 0; i < transformed.size(); ++i) {
-        if (fabsf(transformed[i].y - minY) < 0.1f) {
-            result.push_back(transformed[i]);
+        if (fabsf(transformed[i].y - minY) >= 0.1f) {
+            continue;
+        }
+
+        int cellX = (int)floorf(transformed[i].x * 10.0f);
+        int cellZ = (int)floorf(transformed[i].z * 10.0f);
+
+        for (int x = cellX - 1; x <= cellX + 1 && bottomIndex[i] == -1; ++x) {
+            for (int z = cellZ - 1; z <= cellZ + 1 && bottomIndex[i] == -1; ++z) {
+                auto cell = weldGrid.find(boundaryGridKey(x, z));
+
+                if (cell == weldGrid.end()) {
+                    continue;
+                }
+
+                for (auto existing : cell->second) {
+                    aiVector3D offset = bottomPoints[existing] - transformed[i];
+                    offset.y = 0.0f;
+
+                    if (offset.SquareLength() < 0.01f) {
+                        bottomIndex[i] = existing;
+                        break;
+                    }
+                }
+            }
+        }
+
+        if (bottomIndex[i] == -1) {
+            bottomIndex[i] = bottomPoints.size();
+            weldGrid[boundaryGridKey(cellX, cellZ)].push_back(bottomPoints.size());
+            bottomPoints.push_back(transformed[i]);
         }
     }
 
-    std::sort(result.begin(), result.end(), [](const aiVector3D& a, const aiVector3D& b) -> bool {
-        float aAngle = atan2f(a.z, a.x);
-        float bAngle = atan2f(b.z, b.x);
+    // an edge along the bottom is part of the outline if it is only used by one
+    // face lying flat on the bottom or if it is only used by side faces
+    std::map<std::pair<unsigned, unsigned>, std::pair<unsigned, unsigned>> edgeUse;
 
-        return aAngle < bAngle;
-    });
+    for (unsigned faceIndex = 0; faceIndex < mesh->mNumFaces; ++faceIndex) {
+        aiFace* face = &mesh->mFaces[faceIndex];
+        bool isFlat = true;
+
+        for (unsigned i = 0; i < face->mNumIndices; ++i) {
+            isFlat = isFlat && bottomIndex[face->mIndices[i]] != -1;
+        }
+
+        for (unsigned i = 0; i < face->mNumIndices && face->mNumIndices > 1; ++i) {
+            int from = bottomIndex[face->mIndices[i]];
+            int to = bottomIndex[face->mIndices[(i + 1) % face->mNumIndices]];
+
+            if (from == -1 || to == -1 || from == to) {
+                continue;
+            }
+
+            auto& use = edgeUse[std::make_pair(std::min(from, to), std::max(from, to))];
 
-    aiVector3D last = result[0];
+            if (isFlat) {
+                ++use.first;
+            } else {
+                ++use.second;
+            }
+        }
+    }
+
+    std::vector<std::vector<unsigned>> neighbors(bottomPoints.size());
+
+    for (auto& edge : edgeUse) {
+        if (edge.second.first == 1 || (edge.second.first == 0 && edge.second.second > 0)) {
+            neighbors[edge.first.first].push_back(edge.first.second);
+            neighbors[edge.first.second].push_back(edge.first.first);
+        }
+    }
+
+    std::vector<std::vector<unsigned>> loops;
+    unsigned edgeVertexCount = walkBoundaryLoops(neighbors, loops);
+
+    if (loops.empty()) {
+        std::cerr << "Could not follow the outline of " << mesh->mName.C_Str() << ", using its convex hull" << std::endl;
+        buildConvexHullXZ(bottomPoints, result);
+        return;
+    }
+
+    // with more than one loop the largest one is the outside
+    float largestArea = 0.0f;
+
+    for (auto& loop : loops) {
+        std::vector<aiVector3D> points;
+
+        for (auto index : loop) {
+            points.push_back(bottomPoints[index]);
+        }
+
+        float area = loopAreaXZ(points);
+
+        if (fabsf(area) > largestArea) {
+            largestArea = fabsf(area);
+            result = points;
+        }
+    }
+
+    if (loops.size() > 1 || loops[0].size() != edgeVertexCount) {
+        std::cerr << "The outline of " << mesh->mName.C_Str() << " isn't a single loop, using the largest of " << loops.size() << " loops" << std::endl;
+    }
+
+    // keep the same counter clockwise winding the hull uses
+    if (loopAreaXZ(result) < 0.0f) {
+        std::reverse(result.begin(), result.end());
+    }
+}
+
+bool doesSegmentCrossBoundary(const aiVector3D& from, const aiVector3D& to, const std::vector<aiVector3D>& boundary) {
+    for (unsigned i = 0; i < boundary.size(); ++i) {
+        if (doSegmentsIntersectXZ(from, to, boundary[i], boundary[(i + 1) % boundary.size()])) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool doesSegmentLeaveBoundary(const aiVector3D& from, const aiVector3D& to, const std::vector<aiVector3D>& boundary) {
+    for (unsigned i = 0; i < boundary.size(); ++i) {
+        if (doSegmentsCrossXZ(from, to, boundary[i], boundary[(i + 1) % boundary.size()])) {
+            return true;
+        }
+    }
+
+    // a segment between two points on the boundary can go across a gap without crossing an edge
+    return !boundary.empty() && signedDistanceToBoundary((from + to) * 0.5f, boundary) < -0.001f;
+}
+
+bool isInsideBoundary(const aiVector3D& point, const std::vector<aiVector3D>& boundary) {
+    bool result = false;
+
+    for (unsigned i = 0; i < boundary.size(); ++i) {
+        const aiVector3D& from = boundary[i];
+        const aiVector3D& to = boundary[(i + 1) % boundary.size()];
+
+        if ((from.z > point.z) != (to.z > point.z) &&
+            point.x < from.x + (point.z - from.z) * (to.x - from.x) / (to.z - from.z)) {
+            result = !result;
+        }
+    }
+
+    return result;
+}
+
+float signedDistanceToBoundary(const aiVector3D& point, const std::vector<aiVector3D>& boundary) {
+    float result = std::numeric_limits<float>::max();
+
+    for (unsigned i = 0; i < boundary.size(); ++i) {
+        aiVector3D from = boundary[i];
+        aiVector3D offset = boundary[(i + 1) % boundary.size()] - from;
+        aiVector3D relative = point - from;
+        offset.y = 0.0f;
+        relative.y = 0.0f;
+
+        float lerp = 0.0f;
+        float edgeLength = offset.SquareLength();
+
+        if (edgeLength > 0.0f) {
+            lerp = std::max(0.0f, std::min(1.0f, (relative * offset) / edgeLength));
+        }
+
+        result = std::min(result, (relative - offset * lerp).Length());
+    }
+
+    return isInsideBoundary(point, boundary) ? result : -result;
+}
+
+void buildBoundaryDistanceField(const std::vector<aiVector3D>& boundary, const aiVector3D& minBoundary, const aiVector3D& maxBoundary, float cellSize, BoundaryDistanceField& result) {
+    result.mMin = minBoundary;
+    result.mCellSize = cellSize;
+    result.mWidth = (unsigned)ceilf((maxBoundary.x - minBoundary.x) / cellSize) + 1;
+    result.mHeight = (unsigned)ceilf((maxBoundary.z - minBoundary.z) / cellSize) + 1;
+    result.mDistances.resize(result.mWidth * result.mHeight);
+
+    for (unsigned z = 0; z < result.mHeight; ++z) {
+        for (unsigned x = 0; x < result.mWidth; ++x) {
+            aiVector3D samplePoint(minBoundary.x + x * cellSize, 0.0f, minBoundary.z + z * cellSize);
+            result.mDistances[z * result.mWidth + x] = signedDistanceToBoundary(samplePoint, boundary);
+        }
+    }
+}
+
+bool doesSegmentTouchRectXZ(const aiVector3D& from, const aiVector3D& to, const aiVector3D& min, const aiVector3D& max) {
+    if (isBetweenXZ(min, max, from) || isBetweenXZ(min, max, to)) {
+        return true;
+    }
+
+    aiVector3D corners[4] = {
+        aiVector3D(min.x, 0.0f, min.z),
+        aiVector3D(max.x, 0.0f, min.z),
+        aiVector3D(max.x, 0.0f, max.z),
+        aiVector3D(min.x, 0.0f, max.z),
+    };
+
+    for (unsigned i = 0; i < 4; ++i) {
+        if (doSegmentsIntersectXZ(from, to, corners[i], corners[(i + 1) % 4])) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void buildBoundaryGrid(const std::vector<aiVector3D>& boundary, const std::vector<bool>& includeEdge, const aiVector3D& minBoundary, const aiVector3D& maxBoundary, float cellSize, BoundaryGrid& result) {
+    result.mMin = minBoundary;
+    result.mCellSize = cellSize;
+    result.mWidth = std::max((unsigned)ceilf((maxBoundary.x - minBoundary.x) / cellSize), 1u);
+    result.mHeight = std::max((unsigned)ceilf((maxBoundary.z - minBoundary.z) / cellSize), 1u);
+
+    std::vector<std::vector<unsigned>> cellEdges(result.mWidth * result.mHeight);
+
+    for (unsigned i = 0; i < boundary.size(); ++i) {
+        if (!includeEdge[i]) {
+            continue;
+        }
 
-    for (unsigned i = 1; i < result.size();) {
-        aiVector3D curr = result[i];
+        const aiVector3D& from = boundary[i];
+        const aiVector3D& to = boundary[(i + 1) % boundary.size()];
 
-        if ((last - curr).SquareLength() < 0.01f) {
-            result.erase(result.begin() + i);
+        int minX = std::max(0, (int)floorf((std::min(from.x, to.x) - minBoundary.x) / cellSize));
+        int minZ = std::max(0, (int)floorf((std::min(from.z, to.z) - minBoundary.z) / cellSize));
+        int maxX = std::min((int)result.mWidth - 1, (int)floorf((std::max(from.x, to.x) - minBoundary.x) / cellSize));
+        int maxZ = std::min((int)result.mHeight - 1, (int)floorf((std::max(from.z, to.z) - minBoundary.z) / cellSize));
+
+        for (int z = minZ; z <= maxZ; ++z) {
+            for (int x = minX; x <= maxX; ++x) {
+                aiVector3D cellMin(minBoundary.x + x * cellSize, 0.0f, minBoundary.z + z * cellSize);
+                aiVector3D cellMax(cellMin.x + cellSize, 0.0f, cellMin.z + cellSize);
+
+                if (doesSegmentTouchRectXZ(from, to, cellMin, cellMax)) {
+                    cellEdges[z * result.mWidth + x].push_back(i);
+                }
+            }
+        }
+    }
+
+    result.mCellStart.clear();
+    result.mCellEdges.clear();
+
+    for (auto& edges : cellEdges) {
+        result.mCellStart.push_back(result.mCellEdges.size());
+        result.mCellEdges.insert(result.mCellEdges.end(), edges.begin(), edges.end());
+    }
+
+    result.mCellStart.push_back(result.mCellEdges.size());
+}
+
+void simplifyBoundarySection(const std::vector<aiVector3D>& boundary, unsigned from, unsigned to, float tolerance, std::vector<bool>& keep) {
+    if (to <= from + 1) {
+        return;
+    }
+
+    const aiVector3D& start = boundary[from % boundary.size()];
+    const aiVector3D& end = boundary[to % boundary.size()];
+
+    aiVector3D offset = end - start;
+    offset.y = 0.0f;
+    float length = offset.Length();
+
+    float furthestDistance = 0.0f;
+    unsigned furthest = from;
+
+    for (unsigned i = from + 1; i < to; ++i) {
+        const aiVector3D& point = boundary[i % boundary.size()];
+        float distance;
+
+        if (length > 0.0f) {
+            distance = fabsf(crossXZ(start, end, point)) / length;
+        } else {
+            aiVector3D pointOffset = point - start;
+            pointOffset.y = 0.0f;
+            distance = pointOffset.Length();
+        }
+
+        if (distance > furthestDistance) {
+            furthestDistance = distance;
+            furthest = i;
+        }
+    }
+
+    if (furthestDistance > tolerance) {
+        keep[furthest % boundary.size()] = true;
+        simplifyBoundarySection(boundary, from, furthest, tolerance, keep);
+        simplifyBoundarySection(boundary, furthest, to, tolerance, keep);
+    }
+}
+
+unsigned simplifyBoundary(std::vector<aiVector3D>& boundary, float tolerance, bool shrink) {
+    if (boundary.size() < 4 || tolerance <= 0.0f) {
+        return 0;
+    }
+
+    // split the loop at the point furthest from the first point
+    unsigned split = 0;
+    float splitDistance = 0.0f;
+
+    for (unsigned i = 1; i < boundary.size(); ++i) {
+        aiVector3D offset = boundary[i] - boundary[0];
+        offset.y = 0.0f;
+
+        if (offset.SquareLength() > splitDistance) {
+            splitDistance = offset.SquareLength();
+            split = i;
+        }
+    }
+
+    std::vector<bool> keep(boundary.size());
+    keep[0] = true;
+    keep[split] = true;
+    simplifyBoundarySection(boundary, 0, split, tolerance, keep);
+    simplifyBoundarySection(boundary, split, boundary.size(), tolerance, keep);
+
+    std::vector<unsigned> kept;
+
+    for (unsigned i = 0; i < boundary.size(); ++i) {
+        if (keep[i]) {
+            kept.push_back(i);
+        }
+    }
+
+    if (kept.size() < 3 || kept.size() == boundary.size()) {
+        return 0;
+    }
+
+    float area = 0.0f;
+
+    for (unsigned i = 0; i < boundary.size(); ++i) {
+        const aiVector3D& a = boundary[i];
+        const aiVector3D& b = boundary[(i + 1) % boundary.size()];
+        area += a.x * b.z - b.x * a.z;
+    }
+
+    // positive when the inside of the loop is on the positive side of crossXZ
+    float inside = area > 0.0f ? 1.0f : -1.0f;
+    // flipped when shrinking so the edges move into the loop instead
+    float pushSide = shrink ? -inside : inside;
+
+    // move each kept edge far enough that the points it replaced are behind it
+    std::vector<aiVector3D> edgeOrigins;
+    std::vector<aiVector3D> edgeDirections;
+
+    for (unsigned i = 0; i < kept.size(); ++i) {
+        unsigned from = kept[i];
+        unsigned to = i + 1 < kept.size() ? kept[i + 1] : kept[0] + boundary.size();
+
+        aiVector3D start = boundary[from];
+        aiVector3D direction = boundary[to % boundary.size()] - start;
+        start.y = 0.0f;
+        direction.y = 0.0f;
+        direction.Normalize();
+
+        aiVector3D pushDirection(direction.z * pushSide, 0.0f, -direction.x * pushSide);
+        float pushOut = 0.0f;
+
+        for (unsigned j = from + 1; j < to; ++j) {
+            aiVector3D offset = boundary[j % boundary.size()] - start;
+            offset.y = 0.0f;
+            pushOut = std::max(pushOut, offset * pushDirection);
+        }
+
+        edgeOrigins.push_back(start + pushDirection * pushOut);
+        edgeDirections.push_back(direction);
+    }
+
+    std::vector<aiVector3D> result;
+
+    for (unsigned i = 0; i < kept.size(); ++i) {
+        unsigned prev = (i + kept.size() - 1) % kept.size();
+
+        const aiVector3D& a = edgeOrigins[prev];
+        const aiVector3D& aDir = edgeDirections[prev];
+        const aiVector3D& b = edgeOrigins[i];
+        const aiVector3D& bDir = edgeDirections[i];
+
+        float denominator = aDir.x * bDir.z - aDir.z * bDir.x;
+        aiVector3D corner;
+
+        if (fabsf(denominator) < 0.0001f) {
+            // the edges are parallel so the kept point only needs to move out with them
+            corner = b;
         } else {
-            last = curr;
-            ++i;
+            float lerp = ((b.x - a.x) * bDir.z - (b.z - a.z) * bDir.x) / denominator;
+            corner = a + aDir * lerp;
+        }
+
+        corner.y = boundary[kept[i]].y;
+        result.push_back(corner);
+    }
+
+    // sharp corners can push edges in ways that no longer enclose the original, or
+    // aren't enclosed by it when shrinking, so only use the simplified loop when it is safe
+    if (shrink) {
+        for (auto& point : result) {
+            if (signedDistanceToBoundary(point, boundary) < -0.001f) {
+                return 0;
+            }
+        }
+    } else {
+        for (auto& point : boundary) {
+            if (signedDistanceToBoundary(point, result) < -0.001f) {
+                return 0;
+            }
         }
     }
 
-    if (result.size() > 1 && (result[0] - result[result.size() - 1]).SquareLength() < 0.01f) {
-        result.erase(result.begin() + result.size() - 1);
+    float resultArea = 0.0f;
+
+    for (unsigned i = 0; i < result.size(); ++i) {
+        const aiVector3D& a = result[i];
+        const aiVector3D& b = result[(i + 1) % result.size()];
+        resultArea += a.x * b.z - b.x * a.z;
+    }
+
+    // the corners can flip the loop inside out
+    if (resultArea * area <= 0.0f) {
+        return 0;
+    }
+
+    // an original edge can still cross the loop between two points on the correct side of it
+    for (unsigned i = 0; i < boundary.size(); ++i) {
+        const aiVector3D& from = boundary[i];
+        const aiVector3D& to = boundary[(i + 1) % boundary.size()];
+
+        for (unsigned j = 0; j < result.size(); ++j) {
+            if (doSegmentsCrossXZ(from, to, result[j], result[(j + 1) % result.size()])) {
+                return 0;
+            }
+        }
+    }
+
+    // the offset corners can make the loop cross itself
+    for (unsigned i = 0; i < result.size(); ++i) {
+        for (unsigned j = i + 2; j < result.size(); ++j) {
+            if (i == 0 && j == result.size() - 1) {
+                continue;
+            }
+
+            if (doSegmentsCrossXZ(result[i], result[i + 1], result[j], result[(j + 1) % result.size()])) {
+                return 0;
+            }
+        }
+    }
+
+    unsigned removed = boundary.size() - result.size();
+    boundary = result;
+    return removed;
+}
+
+bool isConvexLoop(const std::vector<aiVector3D>& points, const std::vector<unsigned>& loop) {
+    for (unsigned i = 0; i < loop.size(); ++i) {
+        const aiVector3D& prev = points[loop[(i + loop.size() - 1) % loop.size()]];
+        const aiVector3D& curr = points[loop[i]];
+        const aiVector3D& next = points[loop[(i + 1) % loop.size()]];
+
+        if (crossXZ(prev, curr, next) < -0.00001f) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool isInsideTriangleXZ(const aiVector3D& a, const aiVector3D& b, const aiVector3D& c, const aiVector3D& point) {
+    return crossXZ(a, b, point) > 0.0f && crossXZ(b, c, point) > 0.0f && crossXZ(c, a, point) > 0.0f;
+}
+
+void decomposeConvex(const std::vector<aiVector3D>& boundary, std::vector<std::vector<aiVector3D>>& result) {
+    std::vector<aiVector3D> points = boundary;
+
+    float area = 0.0f;
+
+    for (unsigned i = 0; i < points.size(); ++i) {
+        const aiVector3D& a = points[i];
+        const aiVector3D& b = points[(i + 1) % points.size()];
+        area += a.x * b.z - b.x * a.z;
+    }
+
+    if (area < 0.0f) {
+        std::reverse(points.begin(), points.end());
+    }
+
+    std::vector<unsigned> remaining;
+
+    for (unsigned i = 0; i < points.size(); ++i) {
+        remaining.push_back(i);
+    }
+
+    if (points.size() <= 3 || isConvexLoop(points, remaining)) {
+        result.push_back(points);
+        return;
+    }
+
+    // ear clipping
+    std::vector<std::vector<unsigned>> pieces;
+
+    while (remaining.size() > 3) {
+        bool foundEar = false;
+
+        for (unsigned i = 0; i < remaining.size(); ++i) {
+            unsigned prev = remaining[(i + remaining.size() - 1) % remaining.size()];
+            unsigned curr = remaining[i];
+            unsigned next = remaining[(i + 1) % remaining.size()];
+
+            if (crossXZ(points[prev], points[curr], points[next]) <= 0.0f) {
+                continue;
+            }
+
+            bool isEar = true;
+
+            for (auto other : remaining) {
+                if (other != prev && other != curr && other != next && isInsideTriangleXZ(points[prev], points[curr], points[next], points[other])) {
+                    isEar = false;
+                    break;
+                }
+            }
+
+            if (isEar) {
+                pieces.push_back({prev, curr, next});
+                remaining.erase(remaining.begin() + i);
+                foundEar = true;
+                break;
+            }
+        }
+
+        if (!foundEar) {
+            // degenerate outline, keep it as a single shape
+            result.push_back(points);
+            return;
+        }
+    }
+
+    pieces.push_back(remaining);
+
+    // hertel mehlhorn, remove diagonals that aren't needed to stay convex
+    bool didMerge = true;
+
+    while (didMerge) {
+        didMerge = false;
+
+        for (unsigned a = 0; a < pieces.size() && !didMerge; ++a) {
+            for (unsigned b = a + 1; b < pieces.size() && !didMerge; ++b) {
+                std::vector<unsigned>& pieceA = pieces[a];
+                std::vector<unsigned>& pieceB = pieces[b];
+
+                for (unsigned i = 0; i < pieceA.size() && !didMerge; ++i) {
+                    unsigned from = pieceA[i];
+                    unsigned to = pieceA[(i + 1) % pieceA.size()];
+
+                    for (unsigned j = 0; j < pieceB.size(); ++j) {
+                        if (pieceB[j] != to || pieceB[(j + 1) % pieceB.size()] != from) {
+                            continue;
+                        }
+
+                        std::vector<unsigned> merged;
+
+                        for (unsigned k = 0; k < pieceA.size(); ++k) {
+                            merged.push_back(pieceA[(i + 1 + k) % pieceA.size()]);
+                        }
+
+                        for (unsigned k = 2; k < pieceB.size(); ++k) {
+                            merged.push_back(pieceB[(j + k) % pieceB.size()]);
+                        }
+
+                        if (isConvexLoop(points, merged)) {
+                            pieceA = merged;
+                            pieces.erase(pieces.begin() + b);
+                            didMerge = true;
+                        }
+
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    for (auto& piece : pieces) {
+        std::vector<aiVector3D> convexPiece;
+
+        for (auto index : piece) {
+            convexPiece.push_back(points[index]);
+        }
+
+        result.push_back(convexPiece);
     }
-}
\ No newline at end of file
+}
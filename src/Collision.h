@@ -4,6 +4,56 @@
 #include <vector>
 #include <assimp/mesh.h>
 
+// outline of the bottom of the mesh in the xz plane wound counter clockwise, follows the
+// mesh edges for concave shapes keeping the largest loop when there are several and falls
+// back to the convex hull of the bottom vertices when there are none
 void extractMeshBoundary(aiMesh* mesh, const aiMatrix4x4& transform, std::vector<aiVector3D>& result);
+// checks in the xz plane if point is inside the boundary loop
+bool isInsideBoundary(const aiVector3D& point, const std::vector<aiVector3D>& boundary);
+// douglas peucker simplification of the boundary loop where the kept edges are pushed
+// out so the result still contains the original, or in so the original contains the
+// result when shrink is set. returns the number of edges removed
+unsigned simplifyBoundary(std::vector<aiVector3D>& boundary, float tolerance, bool shrink);
+// splits the boundary loop into convex counter clockwise pieces by triangulating
+// it and merging triangles back together while they stay convex
+void decomposeConvex(const std::vector<aiVector3D>& boundary, std::vector<std::vector<aiVector3D>>& result);
+// distance in the xz plane to the closest boundary edge, positive inside the boundary and negative outside
+float signedDistanceToBoundary(const aiVector3D& point, const std::vector<aiVector3D>& boundary);
+
+class BoundaryDistanceField {
+public:
+    aiVector3D mMin;
+    float mCellSize;
+    // number of samples along x and z, samples are at the cell corners
+    unsigned mWidth;
+    unsigned mHeight;
+    std::vector<float> mDistances;
+};
+
+void buildBoundaryDistanceField(const std::vector<aiVector3D>& boundary, const aiVector3D& minBoundary, const aiVector3D& maxBoundary, float cellSize, BoundaryDistanceField& result);
+
+// uniform grid over the level listing the boundary edges that touch each cell
+class BoundaryGrid {
+public:
+    aiVector3D mMin;
+    float mCellSize;
+    unsigned mWidth;
+    unsigned mHeight;
+    // the edges of cell i are mCellEdges[mCellStart[i]] to mCellEdges[mCellStart[i + 1]]
+    std::vector<unsigned> mCellStart;
+    // edge i goes from boundary[i] to boundary[(i + 1) % boundary.size()]
+    std::vector<unsigned> mCellEdges;
+};
+
+// only edges where includeEdge[i] is true are added to the grid
+void buildBoundaryGrid(const std::vector<aiVector3D>& boundary, const std::vector<bool>& includeEdge, const aiVector3D& minBoundary, const aiVector3D& maxBoundary, float cellSize, BoundaryGrid& result);
+
+// checks in the xz plane if the line segment touches the rectangle from min to max
+bool doesSegmentTouchRectXZ(const aiVector3D& from, const aiVector3D& to, const aiVector3D& min, const aiVector3D& max);
+// checks in the xz plane if the line segment from -> to touches any edge of the boundary loop
+bool doesSegmentCrossBoundary(const aiVector3D& from, const aiVector3D& to, const std::vector<aiVector3D>& boundary);
+// checks in the xz plane if the line segment from -> to goes outside of the boundary loop
+// segments that only touch or run along the boundary stay inside
+bool doesSegmentLeaveBoundary(const aiVector3D& from, const aiVector3D& to, const std::vector<aiVector3D>& boundary);
 
 #endif
\ No newline at end of file
@@ -1,6 +1,8 @@
 
 #include "CommandLineParser.h"
 
+#include <stdlib.h>
+
 void parseEulerAngles(const std::string& input, aiVector3D& output) {
     std::size_t firstComma = input.find(',');
     std::size_t secondComma = input.find(',', firstComma + 1);
@@ -14,6 +16,7 @@ bool parseCommandLineArguments(int argc, char *argv[], struct CommandLineArgumen
     output.mOutputFile = "";
     output.mPrefix = "output";
     output.mScale = 256.0f;
+    output.mThreadCount = 1;
     output.mExportAnimation = true;
     output.mExportGeometry = true;
     output.mIsLevel = false;
@@ -48,6 +51,19 @@ bool parseCommandLineArguments(int argc, char *argv[], struct CommandLineArgumen
                 case 'r':
                     parseEulerAngles(curr, output.mEulerAngles);
                     break;
+                case 'j':
+                {
+                    char* end;
+                    long threadCount = strtol(curr, &end, 10);
+
+                    if (end == curr || *end != '\0' || threadCount <= 0 || threadCount > 1024) {
+                        std::cerr << "The thread count should be a number from 1 to 1024, got " << curr << std::endl;
+                        hasError = true;
+                    } else {
+                        output.mThreadCount = (unsigned)threadCount;
+                    }
+                    break;
+                }
             }
 
             lastParameter = '\0';
@@ -71,6 +87,10 @@ bool parseCommandLineArguments(int argc, char *argv[], struct CommandLineArgumen
             strcmp(curr, "-r") == 0 || 
             strcmp(curr, "--rotate") == 0) {
             lastParameter = 'r';
+        } else if (
+            strcmp(curr, "-j") == 0 || 
+            strcmp(curr, "--threads") == 0) {
+            lastParameter = 'j';
         } else if (
             strcmp(curr, "-a") == 0 || 
             strcmp(curr, "--animations-only") == 0) {
@@ -13,6 +13,7 @@ struct CommandLineArguments {
     std::string mPrefix;
     std::vector<std::string> mMaterialFiles;
     float mScale;
+    unsigned mThreadCount;
     bool mExportAnimation;
     bool mExportGeometry;
     bool mIsLevel;
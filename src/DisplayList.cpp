@@ -116,6 +116,26 @@ bool PushMatrixCommand::GenerateCommand(CFileDefinition& fileDefinition, std::os
     return true;
 }
 
+PushMatrixByNameCommand::PushMatrixByNameCommand(const std::string& matrixName, bool replace): 
+    DisplayListCommand(DisplayListCommandType::G_MTX),
+    mMatrixName(matrixName),
+    mReplace(replace) {
+
+}
+
+bool PushMatrixByNameCommand::GenerateCommand(CFileDefinition& fileDefinition, std::ostream& output) {
+    output << "gsSPMatrix(&" << mMatrixName << ", G_MTX_MODELVIEW | G_MTX_MUL | ";
+
+    if (mReplace) {
+        output << "G_MTX_NOPUSH";
+    } else {
+        output << "G_MTX_PUSH";
+    }
+
+    output << ")";
+    return true;
+}
+
 PopMatrixCommand::PopMatrixCommand(unsigned int popCount): 
     DisplayListCommand(DisplayListCommandType::G_POPMTX),
     mPopCount(popCount) {
@@ -113,6 +113,14 @@ struct PushMatrixCommand : DisplayListCommand {
     bool mReplace;
 };
 
+struct PushMatrixByNameCommand : DisplayListCommand {
+    PushMatrixByNameCommand(const std::string& matrixName, bool replace);
+    bool GenerateCommand(CFileDefinition& fileDefinition, std::ostream& output);
+
+    std::string mMatrixName;
+    bool mReplace;
+};
+
 struct PopMatrixCommand : DisplayListCommand {
     PopMatrixCommand(unsigned int popCount);
     bool GenerateCommand(CFileDefinition& fileDefinition, std::ostream& output);
@@ -5,6 +5,7 @@
 #include <map>
 #include <assimp/scene.h>
 #include "./Material.h"
+#include "./LevelSettings.h"
 
 struct DisplayListSettings {
     DisplayListSettings();
@@ -20,6 +21,8 @@ struct DisplayListSettings {
     bool mExportAnimation;
     bool mExportGeometry;
     bool mIncludeCulling;
+    unsigned mThreadCount;
+    LevelSettings mLevelSettings;
 };
 
 #endif
\ No newline at end of file
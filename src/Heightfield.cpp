@@ -0,0 +1,90 @@
+#include "Heightfield.h"
+
+#include <math.h>
+#include <algorithm>
+#include <limits>
+
+void buildHeightfield(const std::vector<aiVector3D>& triangles, const aiVector3D& minBoundary, const aiVector3D& maxBoundary, float cellSize, bool includeNormals, Heightfield& result) {
+    result.mMin = minBoundary;
+    result.mCellSize = cellSize;
+    result.mWidth = (unsigned)ceilf((maxBoundary.x - minBoundary.x) / cellSize) + 1;
+    result.mHeight = (unsigned)ceilf((maxBoundary.z - minBoundary.z) / cellSize) + 1;
+
+    unsigned sampleCount = result.mWidth * result.mHeight;
+    result.mHeights.assign(sampleCount, -std::numeric_limits<float>::max());
+    result.mNormals.clear();
+
+    if (includeNormals) {
+        result.mNormals.assign(sampleCount, aiVector3D(0.0f, 1.0f, 0.0f));
+    }
+
+    for (unsigned triangle = 0; triangle + 2 < triangles.size(); triangle += 3) {
+        const aiVector3D& a = triangles[triangle];
+        const aiVector3D& b = triangles[triangle + 1];
+        const aiVector3D& c = triangles[triangle + 2];
+
+        float area = (b.x - a.x) * (c.z - a.z) - (b.z - a.z) * (c.x - a.x);
+
+        // walls have no area from above
+        if (fabsf(area) < 0.000001f) {
+            continue;
+        }
+
+        aiVector3D normal = (b - a) ^ (c - a);
+        normal.Normalize();
+
+        if (normal.y < 0.0f) {
+            normal = -normal;
+        }
+
+        int minX = std::max(0, (int)ceilf((std::min(a.x, std::min(b.x, c.x)) - minBoundary.x) / cellSize));
+        int minZ = std::max(0, (int)ceilf((std::min(a.z, std::min(b.z, c.z)) - minBoundary.z) / cellSize));
+        int maxX = std::min((int)result.mWidth - 1, (int)floorf((std::max(a.x, std::max(b.x, c.x)) - minBoundary.x) / cellSize));
+        int maxZ = std::min((int)result.mHeight - 1, (int)floorf((std::max(a.z, std::max(b.z, c.z)) - minBoundary.z) / cellSize));
+
+        for (int z = minZ; z <= maxZ; ++z) {
+            for (int x = minX; x <= maxX; ++x) {
+                float sampleX = minBoundary.x + x * cellSize;
+                float sampleZ = minBoundary.z + z * cellSize;
+
+                float weightA = ((b.x - sampleX) * (c.z - sampleZ) - (b.z - sampleZ) * (c.x - sampleX)) / area;
+                float weightB = ((c.x - sampleX) * (a.z - sampleZ) - (c.z - sampleZ) * (a.x - sampleX)) / area;
+                float weightC = 1.0f - weightA - weightB;
+
+                if (weightA < -0.0001f || weightB < -0.0001f || weightC < -0.0001f) {
+                    continue;
+                }
+
+                float height = a.y * weightA + b.y * weightB + c.y * weightC;
+                unsigned index = z * result.mWidth + x;
+
+                if (height > result.mHeights[index]) {
+                    result.mHeights[index] = height;
+
+                    if (includeNormals) {
+                        result.mNormals[index] = normal;
+                    }
+                }
+            }
+        }
+    }
+
+    // samples with no geometry above them sit at the lowest point found
+    float lowest = std::numeric_limits<float>::max();
+
+    for (auto height : result.mHeights) {
+        if (height != -std::numeric_limits<float>::max()) {
+            lowest = std::min(lowest, height);
+        }
+    }
+
+    if (lowest == std::numeric_limits<float>::max()) {
+        lowest = 0.0f;
+    }
+
+    for (auto& height : result.mHeights) {
+        if (height == -std::numeric_limits<float>::max()) {
+            height = lowest;
+        }
+    }
+}
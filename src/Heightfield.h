@@ -0,0 +1,23 @@
+#ifndef _HEIGHTFIELD_H
+#define _HEIGHTFIELD_H
+
+#include <assimp/mesh.h>
+#include <vector>
+
+class Heightfield {
+public:
+    aiVector3D mMin;
+    float mCellSize;
+    // number of samples along x and z, samples are at the cell corners
+    unsigned mWidth;
+    unsigned mHeight;
+    // highest point of the geometry above each sample
+    std::vector<float> mHeights;
+    // surface normal at each sample, only filled in when requested
+    std::vector<aiVector3D> mNormals;
+};
+
+// triangles should contain three points per triangle
+void buildHeightfield(const std::vector<aiVector3D>& triangles, const aiVector3D& minBoundary, const aiVector3D& maxBoundary, float cellSize, bool includeNormals, Heightfield& result);
+
+#endif
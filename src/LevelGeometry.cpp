@@ -0,0 +1,439 @@
+#include "LevelGeometry.h"
+
+#include <math.h>
+#include <algorithm>
+#include <limits>
+#include <map>
+#include "SceneModification.h"
+#include "TriangleBVH.h"
+
+void splitMeshesIntoGroups(const std::vector<aiMesh*>& meshes, const std::vector<std::vector<int>>& faceGroups, unsigned groupCount, std::vector<std::vector<aiMesh*>>& result) {
+    result.clear();
+    result.resize(groupCount);
+
+    for (unsigned meshIndex = 0; meshIndex < meshes.size(); ++meshIndex) {
+        aiMesh* mesh = meshes[meshIndex];
+        std::vector<std::vector<aiFace*>> groupFaces(groupCount);
+
+        for (unsigned faceIndex = 0; faceIndex < mesh->mNumFaces; ++faceIndex) {
+            int group = faceGroups[meshIndex][faceIndex];
+
+            if (group >= 0) {
+                groupFaces[group].push_back(&mesh->mFaces[faceIndex]);
+            }
+        }
+
+        for (unsigned group = 0; group < groupCount; ++group) {
+            if (groupFaces[group].size()) {
+                result[group].push_back(subMesh(mesh, groupFaces[group]));
+            }
+        }
+    }
+}
+
+void collectMeshTriangles(const std::vector<aiMesh*>& meshes, std::vector<aiVector3D>& result) {
+    for (auto mesh : meshes) {
+        for (unsigned faceIndex = 0; faceIndex < mesh->mNumFaces; ++faceIndex) {
+            aiFace* face = &mesh->mFaces[faceIndex];
+
+            for (unsigned corner = 2; corner < face->mNumIndices; ++corner) {
+                result.push_back(mesh->mVertices[face->mIndices[0]]);
+                result.push_back(mesh->mVertices[face->mIndices[corner - 1]]);
+                result.push_back(mesh->mVertices[face->mIndices[corner]]);
+            }
+        }
+    }
+}
+
+void getMeshesBounds(const std::vector<aiMesh*>& meshes, aiVector3D& min, aiVector3D& max) {
+    min = aiVector3D(std::numeric_limits<float>::max());
+    max = aiVector3D(-std::numeric_limits<float>::max());
+
+    for (auto mesh : meshes) {
+        for (unsigned i = 0; i < mesh->mNumVertices; ++i) {
+            const aiVector3D& vertex = mesh->mVertices[i];
+            min.x = std::min(min.x, vertex.x); min.y = std::min(min.y, vertex.y); min.z = std::min(min.z, vertex.z);
+            max.x = std::max(max.x, vertex.x); max.y = std::max(max.y, vertex.y); max.z = std::max(max.z, vertex.z);
+        }
+    }
+}
+
+aiVector3D getFaceCenter(const aiMesh* mesh, const aiFace& face) {
+    aiVector3D result;
+
+    for (unsigned i = 0; i < face.mNumIndices; ++i) {
+        result += mesh->mVertices[face.mIndices[i]];
+    }
+
+    if (face.mNumIndices) {
+        result /= (float)face.mNumIndices;
+    }
+
+    return result;
+}
+
+void mergeMeshesByMaterial(const std::vector<aiMesh*>& meshes, std::vector<aiMesh*>& result) {
+    std::map<unsigned, std::vector<unsigned>> meshesByMaterial;
+    // keeps the materials in the order they first show up
+    std::vector<unsigned> materialOrder;
+
+    for (unsigned i = 0; i < meshes.size(); ++i) {
+        if (meshesByMaterial.find(meshes[i]->mMaterialIndex) == meshesByMaterial.end()) {
+            materialOrder.push_back(meshes[i]->mMaterialIndex);
+        }
+
+        meshesByMaterial[meshes[i]->mMaterialIndex].push_back(i);
+    }
+
+    for (auto materialIndex : materialOrder) {
+        std::vector<unsigned>& group = meshesByMaterial[materialIndex];
+
+        aiMesh* merged = new aiMesh();
+        merged->mMaterialIndex = materialIndex;
+        merged->mName = meshes[group[0]]->mName;
+
+        bool hasNormals = false;
+        bool hasUVs = false;
+        bool hasColors = false;
+
+        for (auto meshIndex : group) {
+            merged->mNumVertices += meshes[meshIndex]->mNumVertices;
+            merged->mNumFaces += meshes[meshIndex]->mNumFaces;
+            hasNormals = hasNormals || meshes[meshIndex]->mNormals;
+            hasUVs = hasUVs || meshes[meshIndex]->mTextureCoords[0];
+            hasColors = hasColors || meshes[meshIndex]->mColors[0];
+        }
+
+        merged->mVertices = new aiVector3D[merged->mNumVertices];
+        if (hasNormals) merged->mNormals = new aiVector3D[merged->mNumVertices];
+        if (hasUVs) merged->mTextureCoords[0] = new aiVector3D[merged->mNumVertices];
+        if (hasColors) merged->mColors[0] = new aiColor4D[merged->mNumVertices];
+        merged->mFaces = new aiFace[merged->mNumFaces];
+
+        unsigned vertexOffset = 0;
+        unsigned faceOffset = 0;
+
+        for (auto meshIndex : group) {
+            aiMesh* mesh = meshes[meshIndex];
+
+            for (unsigned i = 0; i < mesh->mNumVertices; ++i) {
+                merged->mVertices[vertexOffset + i] = mesh->mVertices[i];
+                if (hasNormals) merged->mNormals[vertexOffset + i] = mesh->mNormals ? mesh->mNormals[i] : aiVector3D();
+                if (hasUVs) merged->mTextureCoords[0][vertexOffset + i] = mesh->mTextureCoords[0] ? mesh->mTextureCoords[0][i] : aiVector3D();
+                // matches the color written for meshes without vertex colors
+                if (hasColors) merged->mColors[0][vertexOffset + i] = mesh->mColors[0] ? mesh->mColors[0][i] : aiColor4D(0.0f, 0.0f, 0.0f, 1.0f);
+            }
+
+            for (unsigned faceIndex = 0; faceIndex < mesh->mNumFaces; ++faceIndex) {
+                aiFace& face = merged->mFaces[faceOffset + faceIndex];
+                face.mNumIndices = mesh->mFaces[faceIndex].mNumIndices;
+                face.mIndices = new unsigned[face.mNumIndices];
+
+                for (unsigned i = 0; i < face.mNumIndices; ++i) {
+                    face.mIndices[i] = mesh->mFaces[faceIndex].mIndices[i] + vertexOffset;
+                }
+            }
+
+            vertexOffset += mesh->mNumVertices;
+            faceOffset += mesh->mNumFaces;
+        }
+
+        result.push_back(merged);
+    }
+}
+
+aiVector3D getFaceNormal(const aiMesh* mesh, const aiFace& face) {
+    if (face.mNumIndices < 3) {
+        return aiVector3D();
+    }
+
+    const aiVector3D& a = mesh->mVertices[face.mIndices[0]];
+    const aiVector3D& b = mesh->mVertices[face.mIndices[1]];
+    const aiVector3D& c = mesh->mVertices[face.mIndices[2]];
+
+    aiVector3D result = (b - a) ^ (c - a);
+
+    if (result.SquareLength() > 0.0f) {
+        result.Normalize();
+    }
+
+    return result;
+}
+
+void removeHiddenFaces(const std::vector<aiMesh*>& meshes, const aiVector3D& cameraDirection, float coneAngle, bool removeOccluded, std::vector<aiMesh*>& result, unsigned& removedTriangles, unsigned& removedVertices) {
+    aiVector3D toCamera = -cameraDirection;
+    toCamera.Normalize();
+
+    // a face can be seen as long as its normal is within 90 degrees plus the cone angle of the camera
+    float minFacing = cosf(std::min((float)M_PI, (float)M_PI * 0.5f + coneAngle)) - 0.0001f;
+    // faces that face the camera for every direction in the cone are the only ones that always hide what is behind them
+    float occluderFacing = cosf(std::max(0.0f, (float)M_PI * 0.5f - coneAngle));
+
+    aiVector3D min, max;
+    getMeshesBounds(meshes, min, max);
+    float rayLength = (max - min).Length() * 2.0f + 1.0f;
+    float surfaceOffset = rayLength * 0.0005f;
+
+    // the axis of the cone and points around its edge
+    std::vector<aiVector3D> cameraDirections;
+    cameraDirections.push_back(toCamera);
+
+    aiVector3D tangent = fabsf(toCamera.y) < 0.9f ? aiVector3D(0.0f, 1.0f, 0.0f) ^ toCamera : aiVector3D(1.0f, 0.0f, 0.0f) ^ toCamera;
+    tangent.Normalize();
+    aiVector3D bitangent = toCamera ^ tangent;
+
+    if (coneAngle > 0.0f) {
+        for (unsigned i = 0; i < 8; ++i) {
+            float angle = i * (float)M_PI * 0.25f;
+            cameraDirections.push_back(toCamera * cosf(coneAngle) + (tangent * cosf(angle) + bitangent * sinf(angle)) * sinf(coneAngle));
+        }
+    }
+
+    std::vector<aiVector3D> occluderTriangles;
+
+    for (unsigned meshIndex = 0; removeOccluded && meshIndex < meshes.size(); ++meshIndex) {
+        aiMesh* mesh = meshes[meshIndex];
+
+        for (unsigned faceIndex = 0; faceIndex < mesh->mNumFaces; ++faceIndex) {
+            aiFace* face = &mesh->mFaces[faceIndex];
+
+            if (getFaceNormal(mesh, *face) * toCamera < occluderFacing) {
+                continue;
+            }
+
+            for (unsigned corner = 2; corner < face->mNumIndices; ++corner) {
+                occluderTriangles.push_back(mesh->mVertices[face->mIndices[0]]);
+                occluderTriangles.push_back(mesh->mVertices[face->mIndices[corner - 1]]);
+                occluderTriangles.push_back(mesh->mVertices[face->mIndices[corner]]);
+            }
+        }
+    }
+
+    TriangleBVH occluders;
+    buildTriangleBVH(occluderTriangles, occluders);
+
+    std::vector<std::vector<int>> faceGroups;
+    removedTriangles = 0;
+
+    for (auto mesh : meshes) {
+        faceGroups.push_back(std::vector<int>(mesh->mNumFaces));
+
+        for (unsigned faceIndex = 0; faceIndex < mesh->mNumFaces; ++faceIndex) {
+            aiFace* face = &mesh->mFaces[faceIndex];
+            aiVector3D normal = getFaceNormal(mesh, *face);
+
+            if (normal.SquareLength() == 0.0f) {
+                continue;
+            }
+
+            bool isVisible = normal * toCamera >= minFacing;
+
+            if (isVisible && removeOccluded) {
+                std::vector<aiVector3D> samplePoints;
+                samplePoints.push_back(getFaceCenter(mesh, *face));
+
+                for (unsigned i = 0; i < face->mNumIndices; ++i) {
+                    // pull the corners in a bit so rays don't slip along shared edges
+                    samplePoints.push_back(mesh->mVertices[face->mIndices[i]] * 0.9f + samplePoints[0] * 0.1f);
+                }
+
+                isVisible = false;
+
+                for (unsigned point = 0; point < samplePoints.size() && !isVisible; ++point) {
+                    aiVector3D from = samplePoints[point] + normal * surfaceOffset;
+
+                    for (auto& direction : cameraDirections) {
+                        if (!occluders.IsSegmentBlocked(from, from + direction * rayLength)) {
+                            isVisible = true;
+                            break;
+                        }
+                    }
+                }
+            }
+
+            if (!isVisible) {
+                faceGroups.back()[faceIndex] = -1;
+                removedTriangles += face->mNumIndices >= 3 ? face->mNumIndices - 2 : 0;
+            }
+        }
+    }
+
+    std::vector<std::vector<aiMesh*>> groups;
+    splitMeshesIntoGroups(meshes, faceGroups, 1, groups);
+    result = groups[0];
+
+    removedVertices = 0;
+
+    for (auto mesh : meshes) {
+        removedVertices += mesh->mNumVertices;
+    }
+
+    for (auto mesh : result) {
+        removedVertices -= mesh->mNumVertices;
+    }
+}
+
+void splitIntoTiles(const std::vector<aiMesh*>& meshes, float tileSize, std::vector<LevelTile>& result) {
+    aiVector3D min, max;
+    getMeshesBounds(meshes, min, max);
+
+    unsigned width = std::max((unsigned)ceilf((max.x - min.x) / tileSize), 1u);
+    unsigned height = std::max((unsigned)ceilf((max.z - min.z) / tileSize), 1u);
+
+    std::vector<std::vector<int>> faceGroups;
+
+    for (auto mesh : meshes) {
+        faceGroups.push_back(std::vector<int>(mesh->mNumFaces));
+
+        for (unsigned faceIndex = 0; faceIndex < mesh->mNumFaces; ++faceIndex) {
+            aiVector3D center = getFaceCenter(mesh, mesh->mFaces[faceIndex]);
+            int x = std::max(0, std::min((int)width - 1, (int)floorf((center.x - min.x) / tileSize)));
+            int z = std::max(0, std::min((int)height - 1, (int)floorf((center.z - min.z) / tileSize)));
+            faceGroups.back()[faceIndex] = z * width + x;
+        }
+    }
+
+    std::vector<std::vector<aiMesh*>> tileMeshes;
+    splitMeshesIntoGroups(meshes, faceGroups, width * height, tileMeshes);
+
+    result.clear();
+
+    for (unsigned tileIndex = 0; tileIndex < tileMeshes.size(); ++tileIndex) {
+        if (tileMeshes[tileIndex].empty()) {
+            continue;
+        }
+
+        LevelTile tile;
+        tile.mMeshes = tileMeshes[tileIndex];
+        tile.mOrigin = aiVector3D(
+            min.x + ((tileIndex % width) + 0.5f) * tileSize,
+            0.0f,
+            min.z + ((tileIndex / width) + 0.5f) * tileSize
+        );
+
+        for (auto mesh : tile.mMeshes) {
+            for (unsigned i = 0; i < mesh->mNumVertices; ++i) {
+                mesh->mVertices[i] -= tile.mOrigin;
+            }
+        }
+
+        getMeshesBounds(tile.mMeshes, tile.mMin, tile.mMax);
+        result.push_back(tile);
+    }
+}
+
+void buildPotentiallyVisibleSet(const std::vector<aiMesh*>& meshes, float cellSize, float eyeHeight, PotentiallyVisibleSet& result) {
+    aiVector3D min, max;
+    getMeshesBounds(meshes, min, max);
+
+    result.mMin = min;
+    result.mCellSize = cellSize;
+    result.mWidth = std::max((unsigned)ceilf((max.x - min.x) / cellSize), 1u);
+    result.mHeight = std::max((unsigned)ceilf((max.z - min.z) / cellSize), 1u);
+
+    unsigned cellCount = result.mWidth * result.mHeight;
+
+    // faces go in the cell their center is in
+    std::vector<std::vector<int>> faceGroups;
+
+    for (auto mesh : meshes) {
+        faceGroups.push_back(std::vector<int>(mesh->mNumFaces));
+
+        for (unsigned faceIndex = 0; faceIndex < mesh->mNumFaces; ++faceIndex) {
+            aiVector3D center = getFaceCenter(mesh, mesh->mFaces[faceIndex]);
+            int x = std::max(0, std::min((int)result.mWidth - 1, (int)floorf((center.x - min.x) / cellSize)));
+            int z = std::max(0, std::min((int)result.mHeight - 1, (int)floorf((center.z - min.z) / cellSize)));
+            faceGroups.back()[faceIndex] = z * result.mWidth + x;
+        }
+    }
+
+    splitMeshesIntoGroups(meshes, faceGroups, cellCount, result.mCellMeshes);
+
+    std::vector<aiVector3D> triangles;
+    collectMeshTriangles(meshes, triangles);
+    TriangleBVH occluders;
+    buildTriangleBVH(triangles, occluders);
+
+    // the camera can be anywhere above the cell, the targets are the corners of the geometry in a cell
+    std::vector<std::vector<aiVector3D>> eyePoints(cellCount);
+    std::vector<std::vector<aiVector3D>> targetPoints(cellCount);
+
+    for (unsigned cell = 0; cell < cellCount; ++cell) {
+        float cellX = min.x + (cell % result.mWidth) * cellSize;
+        float cellZ = min.z + (cell / result.mWidth) * cellSize;
+        float eyeY = max.y + eyeHeight;
+
+        if (result.mCellMeshes[cell].size()) {
+            aiVector3D cellMin, cellMax;
+            getMeshesBounds(result.mCellMeshes[cell], cellMin, cellMax);
+            eyeY = cellMax.y + eyeHeight;
+
+            for (unsigned corner = 0; corner < 8; ++corner) {
+                targetPoints[cell].push_back(aiVector3D(
+                    (corner & 1) ? cellMax.x : cellMin.x,
+                    (corner & 2) ? cellMax.y : cellMin.y,
+                    (corner & 4) ? cellMax.z : cellMin.z
+                ));
+            }
+
+            targetPoints[cell].push_back((cellMin + cellMax) * 0.5f);
+        }
+
+        eyePoints[cell].push_back(aiVector3D(cellX, eyeY, cellZ));
+        eyePoints[cell].push_back(aiVector3D(cellX + cellSize, eyeY, cellZ));
+        eyePoints[cell].push_back(aiVector3D(cellX, eyeY, cellZ + cellSize));
+        eyePoints[cell].push_back(aiVector3D(cellX + cellSize, eyeY, cellZ + cellSize));
+        eyePoints[cell].push_back(aiVector3D(cellX + cellSize * 0.5f, eyeY, cellZ + cellSize * 0.5f));
+    }
+
+    std::vector<bool> visible(cellCount * cellCount);
+
+    for (unsigned from = 0; from < cellCount; ++from) {
+        for (unsigned to = 0; to < cellCount; ++to) {
+            if (from == to) {
+                visible[from * cellCount + to] = true;
+                continue;
+            }
+
+            for (unsigned eye = 0; eye < eyePoints[from].size() && !visible[from * cellCount + to]; ++eye) {
+                for (auto& target : targetPoints[to]) {
+                    if (!occluders.IsSegmentBlocked(eyePoints[from][eye], target)) {
+                        visible[from * cellCount + to] = true;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    // the rays only sample the cells so anything next to a visible cell is
+    // also treated as visible to keep the result conservative
+    result.mVisibleStart.clear();
+    result.mVisibleCells.clear();
+
+    for (unsigned from = 0; from < cellCount; ++from) {
+        result.mVisibleStart.push_back(result.mVisibleCells.size());
+
+        for (unsigned to = 0; to < cellCount; ++to) {
+            if (result.mCellMeshes[to].empty()) {
+                continue;
+            }
+
+            int toX = to % result.mWidth;
+            int toZ = to / result.mWidth;
+            bool isVisible = false;
+
+            for (int z = std::max(0, toZ - 1); z <= std::min((int)result.mHeight - 1, toZ + 1) && !isVisible; ++z) {
+                for (int x = std::max(0, toX - 1); x <= std::min((int)result.mWidth - 1, toX + 1) && !isVisible; ++x) {
+                    isVisible = visible[from * cellCount + z * result.mWidth + x];
+                }
+            }
+
+            if (isVisible) {
+                result.mVisibleCells.push_back(to);
+            }
+        }
+    }
+
+    result.mVisibleStart.push_back(result.mVisibleCells.size());
+}
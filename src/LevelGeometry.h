@@ -0,0 +1,55 @@
+#ifndef _LEVEL_GEOMETRY_H
+#define _LEVEL_GEOMETRY_H
+
+#include <assimp/mesh.h>
+#include <vector>
+
+// faceGroups[mesh][face] is the group the face belongs to or -1 to drop the face
+// result[group] has a new mesh for each source mesh with faces in that group
+// caller is responsible for freeing the new meshes
+void splitMeshesIntoGroups(const std::vector<aiMesh*>& meshes, const std::vector<std::vector<int>>& faceGroups, unsigned groupCount, std::vector<std::vector<aiMesh*>>& result);
+// three points per triangle in mesh space
+void collectMeshTriangles(const std::vector<aiMesh*>& meshes, std::vector<aiVector3D>& result);
+void getMeshesBounds(const std::vector<aiMesh*>& meshes, aiVector3D& min, aiVector3D& max);
+aiVector3D getFaceCenter(const aiMesh* mesh, const aiFace& face);
+
+// combines all the meshes using the same material into one mesh, vertices are kept in mesh space
+// caller is responsible for freeing the new meshes
+void mergeMeshesByMaterial(const std::vector<aiMesh*>& meshes, std::vector<aiMesh*>& result);
+
+// drops faces that face away from every camera direction within coneAngle radians of cameraDirection
+// when removeOccluded is set faces are also dropped if a handful of points on them are covered by other
+// geometry for a handful of directions in the cone. That check is lossy, a face that is only partly
+// covered between the sample points is still removed
+// the new meshes only keep the vertices that are still used, caller is responsible for freeing them
+void removeHiddenFaces(const std::vector<aiMesh*>& meshes, const aiVector3D& cameraDirection, float coneAngle, bool removeOccluded, std::vector<aiMesh*>& result, unsigned& removedTriangles, unsigned& removedVertices);
+
+class LevelTile {
+public:
+    // the tile meshes are moved so this point is at their origin
+    aiVector3D mOrigin;
+    // bounds of the tile meshes after being moved
+    aiVector3D mMin;
+    aiVector3D mMax;
+    std::vector<aiMesh*> mMeshes;
+};
+
+// splits the meshes into tiles along the xz plane, empty tiles are left out
+void splitIntoTiles(const std::vector<aiMesh*>& meshes, float tileSize, std::vector<LevelTile>& result);
+
+class PotentiallyVisibleSet {
+public:
+    aiVector3D mMin;
+    float mCellSize;
+    unsigned mWidth;
+    unsigned mHeight;
+    // geometry in each cell
+    std::vector<std::vector<aiMesh*>> mCellMeshes;
+    // the cells visible from cell i are mVisibleCells[mVisibleStart[i]] to mVisibleCells[mVisibleStart[i + 1]]
+    std::vector<unsigned> mVisibleStart;
+    std::vector<unsigned> mVisibleCells;
+};
+
+void buildPotentiallyVisibleSet(const std::vector<aiMesh*>& meshes, float cellSize, float eyeHeight, PotentiallyVisibleSet& result);
+
+#endif
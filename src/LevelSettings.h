@@ -0,0 +1,94 @@
+#ifndef _LEVEL_SETTINGS_H
+#define _LEVEL_SETTINGS_H
+
+#include <assimp/mesh.h>
+
+enum class NextNodeCompression {
+    // full nodeCount * nodeCount char table
+    None,
+    // identical rows are shared and the element size is picked from the node count
+    Rows,
+    // shared rows are additionally stored as runs of the same next node
+    RunLength,
+};
+
+// options that only apply when exporting a level
+// these can be set per level in the level def yaml file
+struct LevelSettings {
+    // pathing points closer than this are merged into a single node
+    float mPathfindingWeldDistance = 0.0316f;
+    NextNodeCompression mNextNodeCompression = NextNodeCompression::None;
+    // when not 0 pathing nodes are grouped into clusters of about this many
+    // nodes instead of building the full node count * node count table
+    unsigned mPathfindingClusterSize = 0;
+    // stores the distance from every pathing node to each base
+    bool mPathfindingBaseDistanceFields = false;
+    // when greater than 0 pathing nodes within this distance of the shortcut between
+    // their neighbors are removed, as long as the shortcut doesn't cross the boundary
+    // or any decor collision
+    float mPathfindingSimplifyTolerance = 0.0f;
+    // the precomputed next node table can be turned off for levels that
+    // search the nav graph at runtime instead
+    bool mPathfindingNextNodeTable = true;
+    // writes out the pathing connections and their lengths for runtime searches
+    bool mExportNavGraph = false;
+    // precomputes which pathing nodes and bases can see each other without crossing the boundary
+    bool mLineOfSight = false;
+    // when greater than 0 a grid with cells this size is stored for each base
+    // with the direction to go in each cell to reach the base
+    float mFlowFieldCellSize = 0.0f;
+    // writes out a bounding volume hierarchy of the level geometry triangles
+    bool mExportCollisionBVH = false;
+    // when greater than 0 the height of the level geometry is sampled on a grid with this spacing,
+    // the grid is in level space with the bases and boundary
+    float mHeightfieldCellSize = 0.0f;
+    // stores a compressed surface normal with each height sample
+    bool mHeightfieldNormals = false;
+    // when greater than 0 a bitmap of cells this size marks space
+    // taken up by the boundary, decor, and bases
+    float mOccupancyCellSize = 0.0f;
+    // area around each base marked as taken in the occupancy bitmap
+    float mOccupancyBaseRadius = 0.0f;
+    // when greater than 0 the level geometry is split into cells this size
+    // with a list of the other cells that can be seen from each one. Measured in
+    // model units, the exported grid is scaled and rotated to match the vertices
+    float mPvsCellSize = 0.0f;
+    // how far above the geometry in a cell the camera can be
+    float mPvsEyeHeight = 1.0f;
+    // combines the level geometry meshes that share a material into a single mesh
+    // so each material is only set up once
+    bool mMergeGeometryMaterials = false;
+    // removes level geometry that faces away from a camera looking along
+    // mCameraDirection or up to mCameraConeAngle radians away from it
+    // mCameraDirection is in the exported space, after the model rotation
+    bool mCameraConeCulling = false;
+    aiVector3D mCameraDirection = aiVector3D(0.0f, -1.0f, 0.0f);
+    float mCameraConeAngle = 0.0f;
+    // also removes geometry that looks covered by other geometry for the camera cone
+    // this only samples a few points on each face so it can leave holes in partly covered faces
+    bool mCameraOcclusionCulling = false;
+    // splits the level geometry with a bsp tree so it can be drawn back to front
+    // without the z buffer. Falls back to the other modes when more than
+    // mBspMaxSplits faces would need to be cut
+    bool mBspOrdering = false;
+    unsigned mBspMaxSplits = 1024;
+    // when greater than 0 the level geometry is split into tiles this size, each with its
+    // own origin and culling volume. Not used when mPvsCellSize is set
+    float mTileSize = 0.0f;
+    // writes a fixed point matrix for each decor so the scene display list
+    // doesn't need matrices built by the game at load time
+    bool mBakeDecorMatrices = false;
+    // when greater than 0 the boundary is simplified up to this distance, the
+    // simplified boundary always lies inside the original
+    // defaults to the CollisionSimplifyTolerance of the theme
+    float mBoundarySimplifyTolerance = 0.0f;
+    // when greater than 0 the signed distance to the boundary is sampled
+    // on a grid with this spacing and stored next to the boundary
+    float mBoundaryDistanceCellSize = 0.0f;
+    // 8 or 16, the number of bits used for each boundary distance sample
+    unsigned mBoundaryDistanceBits = 8;
+    // when greater than 0 the boundary edges are indexed by a grid with cells this size
+    float mBoundaryGridCellSize = 0.0f;
+};
+
+#endif
@@ -5,14 +5,23 @@
 #include <fstream>
 #include <sstream>
 #include <math.h>
+#include <map>
+#include <limits>
+#include <iostream>
+#include <algorithm>
 
 #include "FileUtils.h"
 #include "CFileDefinition.h"
 #include "MeshWriter.h"
 #include "Collision.h"
 #include "ThemeWriter.h"
+#include "OccupancyGrid.h"
+#include "LevelGeometry.h"
+#include "BspTree.h"
+#include "MathUtl.h"
+#include "DisplayListGenerator.h"
 
-void populateLevelRecursive(const aiScene* scene, class LevelDefinition& levelDef, ThemeWriter* themeWriter, aiNode* node, const aiMatrix4x4& transform) {
+void populateLevelRecursive(const aiScene* scene, class LevelDefinition& levelDef, ThemeWriter* themeWriter, aiNode* node, const aiMatrix4x4& transform, DisplayListSettings& settings) {
     std::string nodeName = node->mName.C_Str();
 
     if (nodeName.rfind("Base", 0) == 0) {
@@ -37,13 +46,34 @@ void populateLevelRecursive(const aiScene* scene, class LevelDefinition& levelDe
     }
 
     if (nodeName.rfind("Geometry", 0) == 0) {
+        // the geometry is drawn without the node transform but collision and height queries
+        // happen in level space with the bases, boundary and pathing nodes
+        if (!transform.IsIdentity()) {
+            std::cerr << nodeName << " has a transform, it is used for collision but not when the geometry is drawn" << std::endl;
+        }
+
         for (unsigned i = 0; i < node->mNumMeshes; ++i) {
-            levelDef.geometryMeshes.push_back(scene->mMeshes[node->mMeshes[i]]);
+            aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
+            levelDef.geometryMeshes.push_back(mesh);
+
+            for (unsigned faceIndex = 0; faceIndex < mesh->mNumFaces; ++faceIndex) {
+                aiFace* face = &mesh->mFaces[faceIndex];
+
+                for (unsigned corner = 2; corner < face->mNumIndices; ++corner) {
+                    levelDef.geometryTriangles.push_back(transform * mesh->mVertices[face->mIndices[0]]);
+                    levelDef.geometryTriangles.push_back(transform * mesh->mVertices[face->mIndices[corner - 1]]);
+                    levelDef.geometryTriangles.push_back(transform * mesh->mVertices[face->mIndices[corner]]);
+                }
+            }
         }
     }
 
     if (nodeName.rfind("Boundary", 0) == 0) {
         if (node->mNumMeshes > 0) {
+            if (levelDef.boundary.size()) {
+                std::cerr << "Level has more than one Boundary node, only the outline of " << nodeName << " is used" << std::endl;
+            }
+
             aiMesh* mesh = scene->mMeshes[node->mMeshes[0]];
             extractMeshBoundary(mesh, transform, levelDef.boundary);
         }
@@ -52,13 +82,7 @@ void populateLevelRecursive(const aiScene* scene, class LevelDefinition& levelDe
     if (nodeName.rfind("Pathfinding", 0) == 0) {
         if (node->mNumMeshes > 0) {
             aiMesh* mesh = scene->mMeshes[node->mMeshes[0]];
-
-            std::vector<aiVector3D> basePositions;
-            for(unsigned i = 0; i < levelDef.bases.size(); ++i) basePositions.push_back(levelDef.bases[i].position);
-
-            class Pathfinding pathfinding;
-            buildPathingFromMesh(mesh, pathfinding, transform);
-            buildPathfindingDefinition(pathfinding, levelDef.pathfinding, basePositions);
+            buildPathingFromMesh(mesh, levelDef.pathingGraph, transform, settings.mLevelSettings.mPathfindingWeldDistance);
         }
     }
 
@@ -72,12 +96,69 @@ void populateLevelRecursive(const aiScene* scene, class LevelDefinition& levelDe
     }
 
     for (unsigned i = 0; i < node->mNumChildren; ++i) {
-        populateLevelRecursive(scene, levelDef, themeWriter, node->mChildren[i], transform * node->mChildren[i]->mTransformation);
+        populateLevelRecursive(scene, levelDef, themeWriter, node->mChildren[i], transform * node->mChildren[i]->mTransformation, settings);
+    }
+}
+
+// theme decor boundaries are scaled and rotated like the theme vertices, this moves one
+// back into level space at the position of the decor. A single point is the radius of a
+// circle and is only scaled
+bool getDecorFootprint(const DecorDefinition& decor, ThemeWriter* theme, DisplayListSettings& settings, std::vector<aiVector3D>& result) {
+    if (!theme || !theme->GetDecorBoundary(decor.decorID, result) || result.empty()) {
+        return false;
+    }
+
+    if (result.size() == 1) {
+        result[0] = result[0] / settings.mScale;
+        return true;
+    }
+
+    // same rotation the decor gets at runtime
+    aiQuaternion inverseRotation = settings.mRotateModel;
+    inverseRotation.Conjugate();
+    aiQuaternion finalRotation = decor.rotation * inverseRotation;
+
+    for (auto& point : result) {
+        point = decor.position + finalRotation.Rotate(point / settings.mScale);
+    }
+
+    return true;
+}
+
+// decor that blocks movement as boundary loops in level space, circles become octagons around them
+void collectDecorObstacles(const LevelDefinition& levelDef, ThemeWriter* theme, DisplayListSettings& settings, std::vector<std::vector<aiVector3D>>& result) {
+    for (auto& decor : levelDef.decor) {
+        std::vector<aiVector3D> footprint;
+
+        if (!getDecorFootprint(decor, theme, settings, footprint)) {
+            continue;
+        }
+
+        if (footprint.size() == 1) {
+            aiVector3D radius = footprint[0];
+            radius.y = 0.0f;
+            // pushes the corners out so the octagon contains the circle
+            float cornerDistance = radius.Length() / cosf((float)M_PI * 0.125f);
+            footprint.clear();
+
+            for (unsigned i = 0; i < 8; ++i) {
+                float angle = i * (float)M_PI * 0.25f;
+                footprint.push_back(decor.position + aiVector3D(cosf(angle), 0.0f, sinf(angle)) * cornerDistance);
+            }
+        }
+
+        result.push_back(footprint);
     }
 }
 
 void populateLevel(const aiScene* scene, class LevelDefinition& levelDef, ThemeWriter* themeWriter, DisplayListSettings& settings) {
-    populateLevelRecursive(scene, levelDef, themeWriter, scene->mRootNode, aiMatrix4x4());
+    populateLevelRecursive(scene, levelDef, themeWriter, scene->mRootNode, aiMatrix4x4(), settings);
+
+    if (settings.mLevelSettings.mBoundarySimplifyTolerance > 0.0f) {
+        // the level boundary shrinks so it never adds walkable area
+        unsigned removedEdges = simplifyBoundary(levelDef.boundary, settings.mLevelSettings.mBoundarySimplifyTolerance, true);
+        std::cout << "Simplifying level boundary removed " << removedEdges << " edges" << std::endl;
+    }
 
     for (unsigned i = 0; i < levelDef.boundary.size(); ++i) {
         aiVector3D boundaryPoint = levelDef.boundary[i];
@@ -88,6 +169,70 @@ void populateLevel(const aiScene* scene, class LevelDefinition& levelDef, ThemeW
         levelDef.maxBoundary.x = std::max(levelDef.maxBoundary.x, boundaryPoint.x);
         levelDef.maxBoundary.z = std::max(levelDef.maxBoundary.z, boundaryPoint.z);
     }
+
+    if (settings.mLevelSettings.mBoundaryDistanceCellSize > 0.0f && levelDef.boundary.size()) {
+        buildBoundaryDistanceField(levelDef.boundary, levelDef.minBoundary, levelDef.maxBoundary, settings.mLevelSettings.mBoundaryDistanceCellSize, levelDef.boundaryDistance);
+    }
+
+    if (settings.mLevelSettings.mHeightfieldCellSize > 0.0f && levelDef.geometryTriangles.size()) {
+        buildHeightfield(levelDef.geometryTriangles, levelDef.minBoundary, levelDef.maxBoundary, settings.mLevelSettings.mHeightfieldCellSize, settings.mLevelSettings.mHeightfieldNormals, levelDef.heightfield);
+    }
+
+    if (settings.mLevelSettings.mMergeGeometryMaterials && levelDef.geometryMeshes.size()) {
+        std::vector<aiMesh*> mergedMeshes;
+        mergeMeshesByMaterial(levelDef.geometryMeshes, mergedMeshes);
+
+        std::cout << "Merged " << levelDef.geometryMeshes.size() << " level geometry meshes into " << mergedMeshes.size() << " by material" << std::endl;
+
+        levelDef.geometryMeshes = mergedMeshes;
+
+        for (auto mesh : mergedMeshes) {
+            levelDef.ownedGeometryMeshes.push_back(std::unique_ptr<aiMesh>(mesh));
+        }
+    }
+
+    if (settings.mLevelSettings.mCameraConeCulling && levelDef.geometryMeshes.size()) {
+        std::vector<aiMesh*> visibleMeshes;
+        unsigned removedTriangles;
+        unsigned removedVertices;
+
+        // the geometry meshes are still in model space so the camera direction is rotated back into it
+        aiQuaternion inverseRotation = settings.mRotateModel;
+        inverseRotation.Conjugate();
+        aiVector3D cameraDirection = inverseRotation.Rotate(settings.mLevelSettings.mCameraDirection);
+
+        removeHiddenFaces(levelDef.geometryMeshes, cameraDirection, settings.mLevelSettings.mCameraConeAngle, settings.mLevelSettings.mCameraOcclusionCulling, visibleMeshes, removedTriangles, removedVertices);
+
+        levelDef.geometryMeshes = visibleMeshes;
+
+        for (auto mesh : visibleMeshes) {
+            levelDef.ownedGeometryMeshes.push_back(std::unique_ptr<aiMesh>(mesh));
+        }
+
+        std::cout << "Removed " << removedTriangles << " hidden triangles and " << removedVertices << " vertices from the level geometry" << std::endl;
+    }
+
+    // pathfinding waits until the whole scene is loaded since it needs the bases and boundary
+    if (levelDef.pathingGraph.mPathingNodes.size()) {
+        std::vector<aiVector3D> basePositions;
+        for(unsigned i = 0; i < levelDef.bases.size(); ++i) basePositions.push_back(levelDef.bases[i].position);
+
+        if (settings.mLevelSettings.mPathfindingSimplifyTolerance > 0.0f) {
+            std::vector<std::vector<aiVector3D>> obstacles;
+            collectDecorObstacles(levelDef, themeWriter, settings, obstacles);
+            simplifyPathing(levelDef.pathingGraph, levelDef.boundary, obstacles, basePositions, settings.mLevelSettings.mPathfindingSimplifyTolerance);
+        }
+
+        buildPathfindingDefinition(levelDef.pathingGraph, levelDef.pathfinding, basePositions, settings.mLevelSettings, settings.mThreadCount);
+
+        if (settings.mLevelSettings.mLineOfSight) {
+            buildLineOfSight(levelDef.pathfinding, basePositions, levelDef.boundary);
+        }
+
+        if (settings.mLevelSettings.mFlowFieldCellSize > 0.0f) {
+            buildFlowFields(levelDef.pathingGraph, levelDef.pathfinding, basePositions, levelDef.boundary, levelDef.minBoundary, levelDef.maxBoundary, settings.mLevelSettings.mFlowFieldCellSize, levelDef.flowFields);
+        }
+    }
 }
 
 bool generateBoundaryEdge(const aiVector3D& from, const aiVector3D& to, std::ostream& fileContent) {
@@ -115,7 +260,25 @@ bool generateBoundaryEdge(const aiVector3D& from, const aiVector3D& to, std::ost
     return true;
 }
 
-void generateDecorDL(LevelDefinition& levelDef, ThemeWriter* theme, DisplayList& dl) {
+void generateBitsetArray(const std::string& name, const std::vector<unsigned>& words, unsigned rowWords, std::ostream& fileContent) {
+    fileContent << "unsigned int " << name << "[] = {" << std::endl;
+    for (unsigned i = 0; i < words.size(); ++i) {
+        if (i % rowWords == 0) {
+            fileContent << "    ";
+        }
+
+        fileContent << "0x" << std::hex << words[i] << std::dec << ", ";
+
+        if (i % rowWords == rowWords - 1) {
+            fileContent << std::endl;
+        }
+    }
+    fileContent << "};" << std::endl;
+}
+
+// decorMatrices[i] is the name of a baked matrix for levelDef.decor[i]
+// when empty the matrix for decor i is expected at MATRIX_TRANSFORM_SEGMENT_ADDRESS + i
+void generateDecorDL(LevelDefinition& levelDef, ThemeWriter* theme, const std::vector<std::string>& decorMatrices, DisplayList& dl) {
     std::vector<std::pair<unsigned, DecorDefinition>> decorCopy;
 
     for (unsigned i = 0; i < levelDef.decor.size(); ++i) {
@@ -142,12 +305,427 @@ void generateDecorDL(LevelDefinition& levelDef, ThemeWriter* theme, DisplayList&
             currentMaterial = material;
         }
 
-        dl.AddCommand(std::unique_ptr<DisplayListCommand>(new PushMatrixCommand(it->first, false)));
+        if (decorMatrices.size()) {
+            dl.AddCommand(std::unique_ptr<DisplayListCommand>(new PushMatrixByNameCommand(decorMatrices[it->first], false)));
+        } else {
+            dl.AddCommand(std::unique_ptr<DisplayListCommand>(new PushMatrixCommand(it->first, false)));
+        }
         dl.AddCommand(std::unique_ptr<DisplayListCommand>(new CallDisplayListByNameCommand(theme->GetDecorGeo(it->second.decorID))));
         dl.AddCommand(std::unique_ptr<DisplayListCommand>(new PopMatrixCommand(1)));
     }
 }
 
+// s15.16 can only hold values from -32768 up to just under 32768, the matrix is still
+// written when a value doesn't fit but ModelTooLarge is returned like the vertex writer
+ErrorCode generateFixedPointMatrix(const std::string& name, const aiMatrix4x4& transform, std::ostream& fileContent) {
+    ErrorCode result = ErrorCode::None;
+
+    for (unsigned i = 0; i < 16; ++i) {
+        float value = transform[i / 4][i % 4] * 65536.0f + 0.5f;
+
+        if (value < (float)std::numeric_limits<int>::min() || value >= (float)std::numeric_limits<int>::max()) {
+            result = ErrorCode::ModelTooLarge;
+        }
+    }
+
+    unsigned elements[16];
+    toFixedPointMatrix(transform, elements);
+
+    fileContent << "Mtx " << name << " = {{" << std::endl;
+    for (unsigned row = 0; row < 4; ++row) {
+        fileContent << "    {";
+        for (unsigned col = 0; col < 4; ++col) {
+            fileContent << "0x" << std::hex << elements[row * 4 + col] << std::dec << ", ";
+        }
+        fileContent << "}," << std::endl;
+    }
+    fileContent << "}};" << std::endl;
+
+    return result;
+}
+
+const char* smallestUnsignedType(unsigned maxValue) {
+    if (maxValue <= std::numeric_limits<unsigned char>::max()) {
+        return "unsigned char";
+    } else if (maxValue <= std::numeric_limits<unsigned short>::max()) {
+        return "unsigned short";
+    } else {
+        return "unsigned int";
+    }
+}
+
+unsigned smallestUnsignedSize(unsigned maxValue) {
+    if (maxValue <= std::numeric_limits<unsigned char>::max()) {
+        return sizeof(unsigned char);
+    } else if (maxValue <= std::numeric_limits<unsigned short>::max()) {
+        return sizeof(unsigned short);
+    } else {
+        return sizeof(unsigned int);
+    }
+}
+
+unsigned maxUnsignedValue(const std::vector<unsigned>& values) {
+    unsigned maxValue = 0;
+
+    for (auto value : values) {
+        maxValue = std::max(maxValue, value);
+    }
+
+    return maxValue;
+}
+
+void writeUnsignedArray(const std::string& name, const char* type, const std::vector<unsigned>& values, unsigned perLine, std::ostream& fileContent) {
+    fileContent << type << " " << name << "[] = {" << std::endl;
+    for (unsigned i = 0; i < values.size(); ++i) {
+        if (i % perLine == 0) {
+            fileContent << "    ";
+        }
+
+        fileContent << values[i] << ", ";
+
+        if (i % perLine == perLine - 1 || i + 1 == values.size()) {
+            fileContent << std::endl;
+        }
+    }
+    fileContent << "};" << std::endl;
+}
+
+// picks the smallest element type that fits the values, only use this for arrays
+// read by code emitted alongside them. returns the size of the array in bytes
+unsigned generateUnsignedArray(const std::string& name, const std::vector<unsigned>& values, unsigned perLine, std::ostream& fileContent) {
+    unsigned maxValue = maxUnsignedValue(values);
+    writeUnsignedArray(name, smallestUnsignedType(maxValue), values, perLine, fileContent);
+    return values.size() * smallestUnsignedSize(maxValue);
+}
+
+// arrays pointed to by a level struct field always use unsigned short to match the
+// field type, returns false if a value doesn't fit
+bool generateUnsignedShortArray(const std::string& name, const std::vector<unsigned>& values, unsigned perLine, std::ostream& fileContent) {
+    writeUnsignedArray(name, "unsigned short", values, perLine, fileContent);
+
+    if (maxUnsignedValue(values) > std::numeric_limits<unsigned short>::max()) {
+        std::cerr << name << " has values that don't fit in an unsigned short" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+std::string generateClusteredNextNodeTable(PathfindingDefinition& pathfinding, CFileDefinition& fileDefinition, std::ostream& fileContent) {
+    PathfindingClusters& clusters = pathfinding.mClusters;
+    unsigned nodeCount = pathfinding.mNodePositions.size();
+    unsigned clusterCount = clusters.ClusterCount();
+
+    std::string nodeCluster = fileDefinition.GetUniqueName("NodeCluster");
+    std::string nodeLocalIndex = fileDefinition.GetUniqueName("NodeLocalIndex");
+    std::string clusterNodeStart = fileDefinition.GetUniqueName("ClusterNodeStart");
+    std::string clusterNodes = fileDefinition.GetUniqueName("ClusterNodes");
+    std::string clusterTableStart = fileDefinition.GetUniqueName("ClusterTableStart");
+    std::string clusterNextNode = fileDefinition.GetUniqueName("ClusterNextNode");
+    std::string clusterExit = fileDefinition.GetUniqueName("ClusterExit");
+    std::string clusterExitNext = fileDefinition.GetUniqueName("ClusterExitNext");
+    std::string nextNodeLookup = fileDefinition.GetUniqueName("NextNodeLookup");
+
+    generateUnsignedArray(nodeCluster, clusters.mNodeCluster, 16, fileContent);
+    generateUnsignedArray(nodeLocalIndex, clusters.mNodeLocalIndex, 16, fileContent);
+    generateUnsignedArray(clusterNodeStart, clusters.mClusterNodeStart, 16, fileContent);
+    generateUnsignedArray(clusterNodes, clusters.mClusterNodes, 16, fileContent);
+    generateUnsignedArray(clusterTableStart, clusters.mClusterTableStart, 16, fileContent);
+    generateUnsignedArray(clusterNextNode, clusters.mClusterNextNode, 16, fileContent);
+    generateUnsignedArray(clusterExit, clusters.mClusterExit, std::max(clusterCount, 1u), fileContent);
+    generateUnsignedArray(clusterExitNext, clusters.mClusterExitNext, std::max(clusterCount, 1u), fileContent);
+
+    fileContent << "int " << nextNodeLookup << "(int from, int to) {" << std::endl;
+    fileContent << "    int fromCluster = " << nodeCluster << "[from];" << std::endl;
+    fileContent << "    int toCluster = " << nodeCluster << "[to];" << std::endl;
+    fileContent << "    int start = " << clusterNodeStart << "[fromCluster];" << std::endl;
+    fileContent << "    int clusterSize = " << clusterNodeStart << "[fromCluster + 1] - start;" << std::endl;
+    fileContent << "    if (fromCluster != toCluster) {" << std::endl;
+    fileContent << "        int exitIndex = fromCluster * " << clusterCount << " + toCluster;" << std::endl;
+    fileContent << "        if (" << clusterExit << "[exitIndex] >= " << nodeCount << ") {" << std::endl;
+    fileContent << "            return from;" << std::endl;
+    fileContent << "        }" << std::endl;
+    fileContent << "        if (" << clusterExit << "[exitIndex] == from) {" << std::endl;
+    fileContent << "            return " << clusterExitNext << "[exitIndex];" << std::endl;
+    fileContent << "        }" << std::endl;
+    fileContent << "        to = " << clusterExit << "[exitIndex];" << std::endl;
+    fileContent << "    }" << std::endl;
+    fileContent << "    return " << clusterNodes << "[start + " << clusterNextNode << "[" << clusterTableStart << "[fromCluster] + " <<
+        nodeLocalIndex << "[from] * clusterSize + " << nodeLocalIndex << "[to]]];" << std::endl;
+    fileContent << "}" << std::endl;
+
+    std::cout << "Clustered NextNode table for " << nodeCount << " nodes uses " << clusters.mClusterNextNode.size() << " entries in " <<
+        clusterCount << " cluster tables and " << clusters.mClusterExit.size() << " cluster exits" << std::endl;
+
+    return ".nextNode = 0, .nextNodeLookup = " + nextNodeLookup;
+}
+
+// returns the fields to use in the pathfinding definition for the next node table
+std::string generateNextNodeTable(PathfindingDefinition& pathfinding, CFileDefinition& fileDefinition, NextNodeCompression compression, std::ostream& fileContent) {
+    unsigned nodeCount = pathfinding.mNodePositions.size();
+
+    if (pathfinding.mClusters.ClusterCount()) {
+        return generateClusteredNextNodeTable(pathfinding, fileDefinition, fileContent);
+    }
+
+    if (pathfinding.mNextNode.size() != nodeCount * nodeCount) {
+        return ".nextNode = 0";
+    }
+
+    if (compression == NextNodeCompression::None) {
+        if (nodeCount > std::numeric_limits<char>::max() + 1) {
+            std::cerr << "Level has " << nodeCount << " pathing nodes which does not fit in the NextNode char table, set NextNodeCompression to use a larger element size" << std::endl;
+        }
+
+        std::string nextNode = fileDefinition.GetUniqueName("NextNode");
+
+        fileContent << "char " << nextNode << "[] = {" << std::endl;
+        unsigned currIndex = 0;
+        for (unsigned y = 0; y < nodeCount; ++y) {
+            fileContent << "    ";
+            for (unsigned x = 0; x < nodeCount; ++x) {
+                fileContent << pathfinding.mNextNode[currIndex] << ", ";
+                ++currIndex;
+            }
+            fileContent << std::endl;
+        }
+        fileContent << "};" << std::endl;
+
+        return ".nextNode = " + nextNode;
+    }
+
+    // rows that are identical are only written once
+    std::map<std::vector<unsigned>, unsigned> uniqueRowIndex;
+    std::vector<std::vector<unsigned>> uniqueRows;
+    std::vector<unsigned> rowIndex;
+
+    for (unsigned from = 0; from < nodeCount; ++from) {
+        std::vector<unsigned> row(pathfinding.mNextNode.begin() + from * nodeCount, pathfinding.mNextNode.begin() + (from + 1) * nodeCount);
+
+        auto existing = uniqueRowIndex.find(row);
+
+        if (existing == uniqueRowIndex.end()) {
+            rowIndex.push_back(uniqueRows.size());
+            uniqueRowIndex[row] = uniqueRows.size();
+            uniqueRows.push_back(row);
+        } else {
+            rowIndex.push_back(existing->second);
+        }
+    }
+
+    std::string nextNodeRowIndex = fileDefinition.GetUniqueName("NextNodeRowIndex");
+    std::string nextNodeLookup = fileDefinition.GetUniqueName("NextNodeLookup");
+    unsigned compressedSize = generateUnsignedArray(nextNodeRowIndex, rowIndex, 16, fileContent);
+
+    if (compression == NextNodeCompression::Rows) {
+        std::string nextNodeRows = fileDefinition.GetUniqueName("NextNodeRows");
+        std::vector<unsigned> rowData;
+
+        for (auto& row : uniqueRows) {
+            rowData.insert(rowData.end(), row.begin(), row.end());
+        }
+
+        compressedSize += generateUnsignedArray(nextNodeRows, rowData, std::max(nodeCount, 1u), fileContent);
+
+        fileContent << "int " << nextNodeLookup << "(int from, int to) {" << std::endl;
+        fileContent << "    return " << nextNodeRows << "[" << nextNodeRowIndex << "[from] * " << nodeCount << " + to];" << std::endl;
+        fileContent << "}" << std::endl;
+    } else {
+        // each row is stored as a list of runs where runEnd is the
+        // first 'to' index past the run and runValue is the next node for the run
+        std::string nextNodeRowStart = fileDefinition.GetUniqueName("NextNodeRowStart");
+        std::string nextNodeRunEnd = fileDefinition.GetUniqueName("NextNodeRunEnd");
+        std::string nextNodeRunValue = fileDefinition.GetUniqueName("NextNodeRunValue");
+
+        std::vector<unsigned> rowStart;
+        std::vector<unsigned> runEnd;
+        std::vector<unsigned> runValue;
+
+        for (auto& row : uniqueRows) {
+            rowStart.push_back(runEnd.size());
+
+            for (unsigned to = 0; to < row.size(); ++to) {
+                if (to + 1 == row.size() || row[to + 1] != row[to]) {
+                    runEnd.push_back(to + 1);
+                    runValue.push_back(row[to]);
+                }
+            }
+        }
+
+        rowStart.push_back(runEnd.size());
+
+        compressedSize += generateUnsignedArray(nextNodeRowStart, rowStart, 16, fileContent);
+        compressedSize += generateUnsignedArray(nextNodeRunEnd, runEnd, 16, fileContent);
+        compressedSize += generateUnsignedArray(nextNodeRunValue, runValue, 16, fileContent);
+
+        fileContent << "int " << nextNodeLookup << "(int from, int to) {" << std::endl;
+        fileContent << "    int row = " << nextNodeRowIndex << "[from];" << std::endl;
+        fileContent << "    int min = " << nextNodeRowStart << "[row];" << std::endl;
+        fileContent << "    int max = " << nextNodeRowStart << "[row + 1] - 1;" << std::endl;
+        fileContent << "    while (min < max) {" << std::endl;
+        fileContent << "        int mid = (min + max) >> 1;" << std::endl;
+        fileContent << "        if (" << nextNodeRunEnd << "[mid] <= to) {" << std::endl;
+        fileContent << "            min = mid + 1;" << std::endl;
+        fileContent << "        } else {" << std::endl;
+        fileContent << "            max = mid;" << std::endl;
+        fileContent << "        }" << std::endl;
+        fileContent << "    }" << std::endl;
+        fileContent << "    return " << nextNodeRunValue << "[min];" << std::endl;
+        fileContent << "}" << std::endl;
+    }
+
+    std::cout << "NextNode table for " << nodeCount << " nodes " << uniqueRows.size() << " unique rows " <<
+        (nodeCount * nodeCount) << " bytes compressed to about " << compressedSize << " bytes" << std::endl;
+
+    return ".nextNode = 0, .nextNodeLookup = " + nextNodeLookup;
+}
+
+std::string generateCollisionBVH(const TriangleBVH& bvh, CFileDefinition& fileDefinition, std::ostream& fileContent) {
+    std::string bvhTriangles = fileDefinition.GetUniqueName("CollisionTriangles");
+    std::string bvhNodes = fileDefinition.GetUniqueName("CollisionBVH");
+
+    if (bvh.mNodes.size() > 0xFFFF || bvh.mTriangles.size() / 3 > 0xFFFF) {
+        std::cerr << "Level geometry has too many triangles for a collision BVH" << std::endl;
+        return "";
+    }
+
+    // the bvh is in level space like the boundary and pathing nodes, not the scaled and
+    // rotated space of the vertex buffers. Bounds and triangle points are stored as 16 bit
+    // offsets from the root bounds, a point is origin + offset * scale
+    aiVector3D origin = bvh.mNodes[0].mMin;
+    aiVector3D scale = bvh.mNodes[0].mMax - origin;
+
+    for (unsigned axis = 0; axis < 3; ++axis) {
+        scale[axis] = scale[axis] > 0.0f ? scale[axis] / 0xFFFF : 1.0f;
+    }
+
+    fileContent << "unsigned short " << bvhTriangles << "[][3] = {" << std::endl;
+    for (auto& point : bvh.mTriangles) {
+        fileContent << "    {";
+        for (unsigned axis = 0; axis < 3; ++axis) {
+            fileContent << std::max(0, std::min(0xFFFF, (int)roundf((point[axis] - origin[axis]) / scale[axis]))) << ", ";
+        }
+        fileContent << "}," << std::endl;
+    }
+    fileContent << "};" << std::endl;
+    fileContent << std::endl;
+
+    // node bounds are rounded outwards so they still contain the triangles
+
+    fileContent << "struct CollisionBVHNode " << bvhNodes << "[] = {" << std::endl;
+    for (auto& node : bvh.mNodes) {
+        fileContent << "    {{";
+        for (unsigned axis = 0; axis < 3; ++axis) {
+            fileContent << std::max(0, std::min(0xFFFF, (int)floorf((node.mMin[axis] - origin[axis]) / scale[axis]))) << ", ";
+        }
+        fileContent << "}, {";
+        for (unsigned axis = 0; axis < 3; ++axis) {
+            fileContent << std::max(0, std::min(0xFFFF, (int)ceilf((node.mMax[axis] - origin[axis]) / scale[axis]))) << ", ";
+        }
+        fileContent << "}, " << node.mChildOrFirstTriangle << ", " << node.mTriangleCount << "}," << std::endl;
+    }
+    fileContent << "};" << std::endl;
+    fileContent << std::endl;
+
+    std::ostringstream result;
+    result << "    .collisionBVH = {.origin = {" << origin.x << ", " << origin.y << ", " << origin.z << "}, " <<
+        ".scale = {" << scale.x << ", " << scale.y << ", " << scale.z << "}, " <<
+        ".nodes = " << bvhNodes << ", " <<
+        ".nodeCount = " << bvh.mNodes.size() << ", " <<
+        ".triangles = " << bvhTriangles << ", " <<
+        ".triangleCount = " << (bvh.mTriangles.size() / 3) << "}," << std::endl;
+    return result.str();
+}
+
+// the heightfield is in level space like the collision bvh
+std::string generateHeightfield(const Heightfield& heightfield, CFileDefinition& fileDefinition, std::ostream& fileContent) {
+    std::string heights = fileDefinition.GetUniqueName("Heights");
+    std::string normals = "0";
+
+    float minHeight = *std::min_element(heightfield.mHeights.begin(), heightfield.mHeights.end());
+    float maxHeight = *std::max_element(heightfield.mHeights.begin(), heightfield.mHeights.end());
+    float heightScale = maxHeight > minHeight ? (maxHeight - minHeight) / 0xFFFF : 1.0f;
+
+    fileContent << "unsigned short " << heights << "[] = {" << std::endl;
+    for (unsigned z = 0; z < heightfield.mHeight; ++z) {
+        fileContent << "    ";
+        for (unsigned x = 0; x < heightfield.mWidth; ++x) {
+            fileContent << (int)roundf((heightfield.mHeights[z * heightfield.mWidth + x] - minHeight) / heightScale) << ", ";
+        }
+        fileContent << std::endl;
+    }
+    fileContent << "};" << std::endl;
+    fileContent << std::endl;
+
+    if (heightfield.mNormals.size()) {
+        // only x and z are stored, y is always positive and can be rebuilt from them
+        normals = fileDefinition.GetUniqueName("HeightNormals");
+        fileContent << "signed char " << normals << "[] = {" << std::endl;
+        for (unsigned z = 0; z < heightfield.mHeight; ++z) {
+            fileContent << "    ";
+            for (unsigned x = 0; x < heightfield.mWidth; ++x) {
+                const aiVector3D& normal = heightfield.mNormals[z * heightfield.mWidth + x];
+                fileContent << (int)roundf(normal.x * 127.0f) << ", " << (int)roundf(normal.z * 127.0f) << ", ";
+            }
+            fileContent << std::endl;
+        }
+        fileContent << "};" << std::endl;
+        fileContent << std::endl;
+    }
+
+    std::ostringstream result;
+    result << "    .heightfield = {.min = {" << heightfield.mMin.x << ", " << heightfield.mMin.z << "}, " <<
+        ".cellSize = " << heightfield.mCellSize << ", " <<
+        ".width = " << heightfield.mWidth << ", " <<
+        ".height = " << heightfield.mHeight << ", " <<
+        ".heightOffset = " << minHeight << ", " <<
+        ".heightScale = " << heightScale << ", " <<
+        ".heights = " << heights << ", " <<
+        ".normals = " << normals << "}," << std::endl;
+    return result.str();
+}
+
+std::string generateOccupancyGrid(const LevelDefinition& levelDef, ThemeWriter* theme, DisplayListSettings& settings, CFileDefinition& fileDefinition, std::ostream& fileContent) {
+    OccupancyGrid grid(levelDef.minBoundary, levelDef.maxBoundary, settings.mLevelSettings.mOccupancyCellSize);
+
+    grid.MarkOutsideBoundary(levelDef.boundary);
+
+    for (auto& decor : levelDef.decor) {
+        std::vector<aiVector3D> footprint;
+
+        if (!getDecorFootprint(decor, theme, settings, footprint)) {
+            continue;
+        }
+
+        if (footprint.size() == 1) {
+            aiVector3D radius = footprint[0];
+            radius.y = 0.0f;
+            grid.MarkCircle(decor.position, radius.Length());
+        } else {
+            grid.MarkPolygon(footprint);
+        }
+    }
+
+    for (auto& base : levelDef.bases) {
+        grid.MarkCircle(base.position, settings.mLevelSettings.mOccupancyBaseRadius);
+    }
+
+    std::cout << "Occupancy grid " << grid.mWidth << "x" << grid.mHeight << " has " << grid.OccupiedCount() << " occupied cells" << std::endl;
+
+    std::string occupancyBits = fileDefinition.GetUniqueName("Occupancy");
+    generateBitsetArray(occupancyBits, grid.PackBits(), grid.RowWords(), fileContent);
+    fileContent << std::endl;
+
+    std::ostringstream result;
+    result << "    .occupancy = {.min = {" << grid.mMin.x << ", " << grid.mMin.z << "}, " <<
+        ".cellSize = " << grid.mCellSize << ", " <<
+        ".width = " << grid.mWidth << ", " <<
+        ".height = " << grid.mHeight << ", " <<
+        ".rowWords = " << grid.RowWords() << ", " <<
+        ".bits = " << occupancyBits << "}," << std::endl;
+    return result.str();
+}
+
 void generateLevelFromScene(const aiScene* scene, std::string headerFilename, ThemeWriter* theme, DisplayListSettings& settings, std::ostream& headerFile, std::ostream& fileContent) {
     LevelDefinition levelDef;
     levelDef.maxPlayerCount = 0;
@@ -191,17 +769,207 @@ void generateLevelFromScene(const aiScene* scene, std::string headerFilename, Th
 
     DisplayList sceneDisplayList(fileDefinition.GetUniqueName("model_gfx"));
 
+    MaterialCollector levelMaterials;
+    MaterialCollector& materials = theme ? theme->mMaterialCollector : levelMaterials;
+
+    if (!theme) {
+        levelMaterials.CollectMaterialResources(scene, chunks, settings);
+        levelMaterials.GenerateMaterials(fileDefinition, settings, fileContent);
+    }
+
+    // geometry split into smaller display lists called from the scene display list
+    std::vector<std::unique_ptr<aiMesh>> splitSourceMeshes;
+    std::vector<std::unique_ptr<ExtendedMesh>> splitMeshes;
+    std::vector<std::unique_ptr<DisplayList>> geometryDisplayLists;
+
+    PotentiallyVisibleSet pvs;
+    std::vector<std::string> pvsCellDisplayLists;
+
+    BspTree bsp;
+    bool useBsp = false;
+
+    if (settings.mLevelSettings.mBspOrdering && levelDef.geometryMeshes.size()) {
+        useBsp = buildBspTree(levelDef.geometryMeshes, settings.mLevelSettings.mBspMaxSplits, bsp);
+
+        if (!useBsp) {
+            std::cerr << "Level geometry needs more than " << settings.mLevelSettings.mBspMaxSplits << " bsp splits, it will be drawn using the z buffer instead" << std::endl;
+        }
+    }
+
+    if (useBsp) {
+        for (auto& node : bsp.mNodes) {
+            std::vector<RenderChunk> nodeChunks;
+
+            for (auto mesh : node.mMeshes) {
+                splitSourceMeshes.push_back(std::unique_ptr<aiMesh>(mesh));
+                splitMeshes.push_back(std::unique_ptr<ExtendedMesh>(new ExtendedMesh(mesh, blankBones)));
+                nodeChunks.push_back(RenderChunk(std::pair<Bone*, Bone*>(nullptr, nullptr), splitMeshes.back().get(), VertexType::PosUVColor));
+            }
+
+            geometryDisplayLists.push_back(std::unique_ptr<DisplayList>(new DisplayList(fileDefinition.GetUniqueName("bsp_node_gfx"))));
+            generateMeshIntoDLWithMaterials(scene, fileDefinition, materials, nodeChunks, settings, *geometryDisplayLists.back());
+            // the static scene still draws every node so it works with the z buffer on
+            sceneDisplayList.AddCommand(std::unique_ptr<DisplayListCommand>(new CallDisplayListByNameCommand(geometryDisplayLists.back()->GetName())));
+        }
+
+        std::cout << "Split level geometry into " << bsp.mNodes.size() << " bsp nodes cutting " << bsp.mSplitCount << " faces" << std::endl;
+    } else if (settings.mLevelSettings.mPvsCellSize > 0.0f && levelDef.geometryMeshes.size()) {
+        buildPotentiallyVisibleSet(levelDef.geometryMeshes, settings.mLevelSettings.mPvsCellSize, settings.mLevelSettings.mPvsEyeHeight, pvs);
+
+        for (auto& cellMeshes : pvs.mCellMeshes) {
+            if (cellMeshes.empty()) {
+                pvsCellDisplayLists.push_back("0");
+                continue;
+            }
+
+            std::vector<RenderChunk> cellChunks;
+
+            for (auto mesh : cellMeshes) {
+                splitSourceMeshes.push_back(std::unique_ptr<aiMesh>(mesh));
+                splitMeshes.push_back(std::unique_ptr<ExtendedMesh>(new ExtendedMesh(mesh, blankBones)));
+                cellChunks.push_back(RenderChunk(std::pair<Bone*, Bone*>(nullptr, nullptr), splitMeshes.back().get(), VertexType::PosUVColor));
+            }
+
+            geometryDisplayLists.push_back(std::unique_ptr<DisplayList>(new DisplayList(fileDefinition.GetUniqueName("pvs_cell_gfx"))));
+            generateMeshIntoDLWithMaterials(scene, fileDefinition, materials, cellChunks, settings, *geometryDisplayLists.back());
+            sceneDisplayList.AddCommand(std::unique_ptr<DisplayListCommand>(new CallDisplayListByNameCommand(geometryDisplayLists.back()->GetName())));
+            pvsCellDisplayLists.push_back(geometryDisplayLists.back()->GetName());
+        }
+
+        std::cout << "Split level geometry into " << geometryDisplayLists.size() << " visibility cells seeing on average " <<
+            ((float)pvs.mVisibleCells.size() / (pvs.mWidth * pvs.mHeight)) << " cells" << std::endl;
+    } else if (settings.mLevelSettings.mTileSize > 0.0f && levelDef.geometryMeshes.size()) {
+        std::vector<LevelTile> tiles;
+        splitIntoTiles(levelDef.geometryMeshes, settings.mLevelSettings.mTileSize, tiles);
+
+        for (auto& tile : tiles) {
+            std::vector<RenderChunk> tileChunks;
+
+            for (auto mesh : tile.mMeshes) {
+                splitSourceMeshes.push_back(std::unique_ptr<aiMesh>(mesh));
+                splitMeshes.push_back(std::unique_ptr<ExtendedMesh>(new ExtendedMesh(mesh, blankBones)));
+                tileChunks.push_back(RenderChunk(std::pair<Bone*, Bone*>(nullptr, nullptr), splitMeshes.back().get(), VertexType::PosUVColor));
+            }
+
+            geometryDisplayLists.push_back(std::unique_ptr<DisplayList>(new DisplayList(fileDefinition.GetUniqueName("tile_gfx"))));
+            DisplayList& tileDisplayList = *geometryDisplayLists.back();
+
+            // the culling volume is checked after the tile matrix is applied so it is in tile space
+            generateCulling(tileDisplayList, fileDefinition.GetCullingBuffer(tileDisplayList.GetName() + "_culling", tile.mMin, tile.mMax), false);
+            generateMeshIntoDLWithMaterials(scene, fileDefinition, materials, tileChunks, settings, tileDisplayList);
+
+            aiMatrix4x4 tileTransform;
+            aiMatrix4x4::Translation(settings.mRotateModel.Rotate(tile.mOrigin) * settings.mScale, tileTransform);
+            std::string tileMatrix = fileDefinition.GetUniqueName("tile_mtx");
+            if (generateFixedPointMatrix(tileMatrix, tileTransform, fileContent) != ErrorCode::None) {
+                std::cerr << "The origin of " << tileMatrix << " is too far away for a fixed point matrix, try a smaller scale" << std::endl;
+            }
+
+            // the matrix is pushed here since a culled tile display list returns early
+            sceneDisplayList.AddCommand(std::unique_ptr<DisplayListCommand>(new PushMatrixByNameCommand(tileMatrix, false)));
+            sceneDisplayList.AddCommand(std::unique_ptr<DisplayListCommand>(new CallDisplayListByNameCommand(tileDisplayList.GetName())));
+            sceneDisplayList.AddCommand(std::unique_ptr<DisplayListCommand>(new PopMatrixCommand(1)));
+        }
+
+        fileContent << std::endl;
+        std::cout << "Split level geometry into " << tiles.size() << " tiles" << std::endl;
+    } else {
+        generateMeshIntoDLWithMaterials(scene, fileDefinition, materials, chunks, settings, sceneDisplayList);
+    }
+
     if (theme) {
-        generateMeshIntoDLWithMaterials(scene, fileDefinition, theme->mMaterialCollector, chunks, settings, sceneDisplayList);
+        std::vector<std::string> decorMatrices;
+
+        if (settings.mLevelSettings.mBakeDecorMatrices) {
+            aiQuaternion inverseRotation = settings.mRotateModel;
+            inverseRotation.Conjugate();
+
+            for (auto& decor : levelDef.decor) {
+                // same transform the game would build from the decor definition
+                aiMatrix4x4 decorTransform;
+                aiMatrix4x4::Translation(decor.position * settings.mScale, decorTransform);
+                decorTransform = decorTransform * aiMatrix4x4((decor.rotation * inverseRotation).GetMatrix());
+
+                decorMatrices.push_back(fileDefinition.GetUniqueName("decor_mtx"));
+                if (generateFixedPointMatrix(decorMatrices.back(), decorTransform, fileContent) != ErrorCode::None) {
+                    std::cerr << "The position of " << decorMatrices.back() << " is too far away for a fixed point matrix, try a smaller scale" << std::endl;
+                }
+            }
+
+            fileContent << std::endl;
+        }
+
         sceneDisplayList.AddCommand(std::unique_ptr<DisplayListCommand>(new CommentCommand("Begin decor")));
-        generateDecorDL(levelDef, theme, sceneDisplayList);
-        fileDefinition.GenerateVertexBuffers(fileContent, settings.mScale, settings.mRotateModel);
-    } else {
-        generateMeshIntoDL(scene, fileDefinition, chunks, settings, sceneDisplayList, fileContent);
+        generateDecorDL(levelDef, theme, decorMatrices, sceneDisplayList);
+    }
+
+    fileDefinition.GenerateVertexBuffers(fileContent, settings.mScale, settings.mRotateModel);
+
+    for (auto& displayList : geometryDisplayLists) {
+        displayList->Generate(fileDefinition, fileContent);
     }
 
     sceneDisplayList.Generate(fileDefinition, fileContent);
 
+    std::string bspField = "";
+
+    if (useBsp) {
+        std::string bspNodes = fileDefinition.GetUniqueName("BspNodes");
+
+        fileContent << "struct BspNode " << bspNodes << "[] = {" << std::endl;
+        for (unsigned i = 0; i < bsp.mNodes.size(); ++i) {
+            // the plane is moved into the same space as the vertex buffers
+            aiVector3D normal = settings.mRotateModel.Rotate(bsp.mNodes[i].mNormal);
+            fileContent << "    {{" << normal.x << ", " << normal.y << ", " << normal.z << "}, " <<
+                (bsp.mNodes[i].mDistance * settings.mScale) << ", " <<
+                bsp.mNodes[i].mFront << ", " <<
+                bsp.mNodes[i].mBack << ", " <<
+                geometryDisplayLists[i]->GetName() << "}," << std::endl;
+        }
+        fileContent << "};" << std::endl;
+        fileContent << std::endl;
+
+        std::ostringstream bspFields;
+        bspFields << "    .bsp = {.nodes = " << bspNodes << ", .nodeCount = " << bsp.mNodes.size() << "}," << std::endl;
+        bspField = bspFields.str();
+    }
+
+    std::string pvsField = "";
+
+    if (pvsCellDisplayLists.size()) {
+        std::string pvsCells = fileDefinition.GetUniqueName("PvsCells");
+        std::string pvsVisibleStart = fileDefinition.GetUniqueName("PvsVisibleStart");
+        std::string pvsVisibleCells = fileDefinition.GetUniqueName("PvsVisibleCells");
+
+        fileContent << "Gfx* " << pvsCells << "[] = {" << std::endl;
+        for (auto& name : pvsCellDisplayLists) {
+            fileContent << "    " << name << "," << std::endl;
+        }
+        fileContent << "};" << std::endl;
+
+        generateUnsignedShortArray(pvsVisibleStart, pvs.mVisibleStart, 16, fileContent);
+        generateUnsignedShortArray(pvsVisibleCells, pvs.mVisibleCells, 16, fileContent);
+        fileContent << std::endl;
+
+        // the grid is emitted in the same space as the vertex buffers and bsp planes, the
+        // cell column of a point p is dot(p - min, xAxis) / cellSize and the row uses zAxis
+        aiVector3D pvsMin = settings.mRotateModel.Rotate(pvs.mMin) * settings.mScale;
+        aiVector3D pvsXAxis = settings.mRotateModel.Rotate(aiVector3D(1.0f, 0.0f, 0.0f));
+        aiVector3D pvsZAxis = settings.mRotateModel.Rotate(aiVector3D(0.0f, 0.0f, 1.0f));
+
+        std::ostringstream pvsFields;
+        pvsFields << "    .pvs = {.min = {" << pvsMin.x << ", " << pvsMin.y << ", " << pvsMin.z << "}, " <<
+            ".xAxis = {" << pvsXAxis.x << ", " << pvsXAxis.y << ", " << pvsXAxis.z << "}, " <<
+            ".zAxis = {" << pvsZAxis.x << ", " << pvsZAxis.y << ", " << pvsZAxis.z << "}, " <<
+            ".cellSize = " << (pvs.mCellSize * settings.mScale) << ", " <<
+            ".width = " << pvs.mWidth << ", " <<
+            ".height = " << pvs.mHeight << ", " <<
+            ".cellDisplayLists = " << pvsCells << ", " <<
+            ".visibleStart = " << pvsVisibleStart << ", " <<
+            ".visibleCells = " << pvsVisibleCells << "}," << std::endl;
+        pvsField = pvsFields.str();
+    }
+
     std::string basesName = fileDefinition.GetUniqueName("Bases");
 
     fileContent << "struct BaseDefinition " << basesName << "[] = {" << std::endl;
@@ -228,14 +996,106 @@ void generateLevelFromScene(const aiScene* scene, std::string headerFilename, Th
     std::string boundary = fileDefinition.GetUniqueName("Boundary");
     fileContent << "struct SceneBoundary " << boundary << "[] = {" << std::endl;
     unsigned actualBoundaryCount = 0;
+    // short edges are skipped so the grid needs to know where each edge ended up
+    std::vector<bool> boundaryWritten(levelDef.boundary.size());
+    std::vector<unsigned> boundaryIndex(levelDef.boundary.size());
     for (unsigned i = 0; i < levelDef.boundary.size(); ++i) {
+        boundaryIndex[i] = actualBoundaryCount;
         if (generateBoundaryEdge(levelDef.boundary[i], levelDef.boundary[(i + 1) % levelDef.boundary.size()], fileContent)) {
+            boundaryWritten[i] = true;
             ++actualBoundaryCount;
         }
     }
     fileContent << "};" << std::endl;
     fileContent << std::endl;
 
+    std::string boundaryGridField = "";
+
+    if (settings.mLevelSettings.mBoundaryGridCellSize > 0.0f && actualBoundaryCount) {
+        BoundaryGrid boundaryGrid;
+        buildBoundaryGrid(levelDef.boundary, boundaryWritten, levelDef.minBoundary, levelDef.maxBoundary, settings.mLevelSettings.mBoundaryGridCellSize, boundaryGrid);
+
+        for (auto& edge : boundaryGrid.mCellEdges) {
+            edge = boundaryIndex[edge];
+        }
+
+        unsigned cellCount = boundaryGrid.mWidth * boundaryGrid.mHeight;
+        std::cout << "Boundary grid " << boundaryGrid.mWidth << "x" << boundaryGrid.mHeight << " averages " <<
+            ((float)boundaryGrid.mCellEdges.size() / cellCount) << " edges per cell" << std::endl;
+
+        std::string boundaryGridStart = fileDefinition.GetUniqueName("BoundaryGridStart");
+        std::string boundaryGridEdges = fileDefinition.GetUniqueName("BoundaryGridEdges");
+        generateUnsignedShortArray(boundaryGridStart, boundaryGrid.mCellStart, boundaryGrid.mWidth + 1, fileContent);
+        generateUnsignedShortArray(boundaryGridEdges, boundaryGrid.mCellEdges, 16, fileContent);
+        fileContent << std::endl;
+
+        std::ostringstream boundaryGridFields;
+        boundaryGridFields << "    .boundaryGrid = {.min = {" << boundaryGrid.mMin.x << ", " << boundaryGrid.mMin.z << "}, " <<
+            ".cellSize = " << boundaryGrid.mCellSize << ", " <<
+            ".width = " << boundaryGrid.mWidth << ", " <<
+            ".height = " << boundaryGrid.mHeight << ", " <<
+            ".cellStart = " << boundaryGridStart << ", " <<
+            ".cellEdges = " << boundaryGridEdges << "}," << std::endl;
+        boundaryGridField = boundaryGridFields.str();
+    }
+
+    std::string boundaryDistanceField = "";
+
+    if (levelDef.boundaryDistance.mDistances.size()) {
+        BoundaryDistanceField& distanceField = levelDef.boundaryDistance;
+        std::string boundaryDistances = fileDefinition.GetUniqueName("BoundaryDistance");
+
+        float maxDistance = 0.0f;
+
+        for (auto distance : distanceField.mDistances) {
+            maxDistance = std::max(maxDistance, fabsf(distance));
+        }
+
+        int maxValue = settings.mLevelSettings.mBoundaryDistanceBits == 16 ? 32767 : 127;
+        float scale = maxDistance > 0.0f ? maxDistance / maxValue : 1.0f;
+
+        fileContent << (maxValue == 127 ? "signed char " : "short ") << boundaryDistances << "[] = {" << std::endl;
+        for (unsigned z = 0; z < distanceField.mHeight; ++z) {
+            fileContent << "    ";
+            for (unsigned x = 0; x < distanceField.mWidth; ++x) {
+                int value = (int)roundf(distanceField.mDistances[z * distanceField.mWidth + x] / scale);
+                fileContent << std::max(-maxValue, std::min(maxValue, value)) << ", ";
+            }
+            fileContent << std::endl;
+        }
+        fileContent << "};" << std::endl;
+        fileContent << std::endl;
+
+        std::ostringstream boundaryDistanceFields;
+        boundaryDistanceFields << "    .boundaryDistance = {.min = {" << distanceField.mMin.x << ", " << distanceField.mMin.z << "}, " <<
+            ".cellSize = " << distanceField.mCellSize << ", " <<
+            ".width = " << distanceField.mWidth << ", " <<
+            ".height = " << distanceField.mHeight << ", " <<
+            ".distanceScale = " << scale << ", " <<
+            ".distances = " << boundaryDistances << "}," << std::endl;
+        boundaryDistanceField = boundaryDistanceFields.str();
+    }
+
+    std::string heightfieldField = "";
+
+    if (levelDef.heightfield.mHeights.size()) {
+        heightfieldField = generateHeightfield(levelDef.heightfield, fileDefinition, fileContent);
+    }
+
+    std::string occupancyField = "";
+
+    if (settings.mLevelSettings.mOccupancyCellSize > 0.0f) {
+        occupancyField = generateOccupancyGrid(levelDef, theme, settings, fileDefinition, fileContent);
+    }
+
+    std::string collisionBVHField = "";
+
+    if (settings.mLevelSettings.mExportCollisionBVH && levelDef.geometryTriangles.size()) {
+        TriangleBVH bvh;
+        buildTriangleBVH(levelDef.geometryTriangles, bvh);
+        collisionBVHField = generateCollisionBVH(bvh, fileDefinition, fileContent);
+    }
+
     std::string decorList = "0";
     aiQuaternion inverseRotation = settings.mRotateModel;
     inverseRotation.Conjugate();
@@ -278,19 +1138,96 @@ void generateLevelFromScene(const aiScene* scene, std::string headerFilename, Th
     }
     fileContent << "};" << std::endl;
 
-    std::string nextNode = fileDefinition.GetUniqueName("NextNode");
+    std::string baseDistanceFields = "";
 
-    fileContent << "char " << nextNode << "[] = {" << std::endl;
-    unsigned currIndex = 0;
-    for (unsigned y = 0; y < levelDef.pathfinding.mNodePositions.size(); ++y) {
-        fileContent << "    ";
-        for (unsigned x = 0; x < levelDef.pathfinding.mNodePositions.size(); ++x) {
-            fileContent << levelDef.pathfinding.mNextNode[currIndex] << ", ";
-            ++currIndex;
+    if (levelDef.pathfinding.mBaseDistanceFields.size()) {
+        std::string baseDistanceFieldsName = fileDefinition.GetUniqueName("BaseDistanceFields");
+        unsigned nodeCount = levelDef.pathfinding.mNodePositions.size();
+
+        fileContent << "float " << baseDistanceFieldsName << "[] = {" << std::endl;
+        for (unsigned base = 0; base < levelDef.pathfinding.baseNodes.size(); ++base) {
+            fileContent << "    ";
+            for (unsigned node = 0; node < nodeCount; ++node) {
+                fileContent << levelDef.pathfinding.mBaseDistanceFields[base * nodeCount + node] << ", ";
+            }
+            fileContent << std::endl;
         }
-        fileContent << std::endl;
+        fileContent << "};" << std::endl;
+
+        baseDistanceFields = ", .baseDistanceFields = " + baseDistanceFieldsName;
+    }
+
+    std::string navGraphFields = "";
+
+    if (settings.mLevelSettings.mExportNavGraph) {
+        Pathfinding& graph = levelDef.pathingGraph;
+
+        std::string navGraphEdgeStart = fileDefinition.GetUniqueName("NavGraphEdgeStart");
+        std::string navGraphEdges = fileDefinition.GetUniqueName("NavGraphEdges");
+        std::string navGraphEdgeCosts = fileDefinition.GetUniqueName("NavGraphEdgeCosts");
+
+        if (graph.mAdjacencyStart.empty()) {
+            graph.BuildAdjacency();
+        }
+
+        generateUnsignedShortArray(navGraphEdgeStart, graph.mAdjacencyStart, 16, fileContent);
+        generateUnsignedShortArray(navGraphEdges, graph.mAdjacentNodes, 16, fileContent);
+
+        fileContent << "float " << navGraphEdgeCosts << "[] = {" << std::endl;
+        for (unsigned i = 0; i < graph.mEdgeLengths.size(); ++i) {
+            fileContent << "    " << graph.mEdgeLengths[i] << "," << std::endl;
+        }
+        fileContent << "};" << std::endl;
+
+        navGraphFields = ", .navGraph = {.edgeCount = " + std::to_string(graph.mAdjacentNodes.size()) + 
+            ", .edgeStart = " + navGraphEdgeStart + 
+            ", .edges = " + navGraphEdges + 
+            ", .edgeCosts = " + navGraphEdgeCosts + "}";
+    }
+
+    std::string visibilityFields = "";
+
+    if (levelDef.pathfinding.mNodeVisibility.size()) {
+        std::string nodeVisibility = fileDefinition.GetUniqueName("NodeVisibility");
+        std::string baseVisibility = fileDefinition.GetUniqueName("BaseVisibility");
+        unsigned rowWords = levelDef.pathfinding.VisibilityRowWords();
+
+        generateBitsetArray(nodeVisibility, levelDef.pathfinding.mNodeVisibility, rowWords, fileContent);
+        generateBitsetArray(baseVisibility, levelDef.pathfinding.mBaseVisibility, rowWords, fileContent);
+
+        visibilityFields = ", .nodeVisibility = " + nodeVisibility + ", .baseVisibility = " + baseVisibility;
+    }
+
+    std::string nextNodeFields = generateNextNodeTable(levelDef.pathfinding, fileDefinition, settings.mLevelSettings.mNextNodeCompression, fileContent);
+
+    std::string flowFields = "";
+
+    if (levelDef.flowFields.mDirections.size()) {
+        FlowFieldDefinition& flowFieldDef = levelDef.flowFields;
+        std::string flowFieldDirections = fileDefinition.GetUniqueName("FlowFieldDirections");
+        unsigned cellCount = flowFieldDef.mWidth * flowFieldDef.mHeight;
+
+        fileContent << "unsigned char " << flowFieldDirections << "[] = {" << std::endl;
+        for (unsigned base = 0; base < flowFieldDef.mBaseCount; ++base) {
+            fileContent << "    // base " << base << std::endl;
+            for (unsigned y = 0; y < flowFieldDef.mHeight; ++y) {
+                fileContent << "    ";
+                for (unsigned x = 0; x < flowFieldDef.mWidth; ++x) {
+                    fileContent << (unsigned)flowFieldDef.mDirections[base * cellCount + y * flowFieldDef.mWidth + x] << ", ";
+                }
+                fileContent << std::endl;
+            }
+        }
+        fileContent << "};" << std::endl;
+
+        std::ostringstream flowFieldFields;
+        flowFieldFields << "    .flowFields = {.min = {" << flowFieldDef.mMin.x << ", " << flowFieldDef.mMin.z << "}, " <<
+            ".cellSize = " << flowFieldDef.mCellSize << ", " <<
+            ".width = " << flowFieldDef.mWidth << ", " <<
+            ".height = " << flowFieldDef.mHeight << ", " <<
+            ".directions = " << flowFieldDirections << "}," << std::endl;
+        flowFields = flowFieldFields.str();
     }
-    fileContent << "};" << std::endl;
 
     fileContent << "struct LevelDefinition " << definitionName << " = {" << std::endl;
     fileContent << "    .maxPlayerCount = " << levelDef.maxPlayerCount << "," << std::endl;
@@ -309,8 +1246,16 @@ void generateLevelFromScene(const aiScene* scene, std::string headerFilename, Th
     }
     fileContent << "," << std::endl;
     fileContent << "    .staticScene = {" << boundary << ", " << actualBoundaryCount << "}," << std::endl;
+    fileContent << boundaryGridField;
+    fileContent << boundaryDistanceField;
+    fileContent << collisionBVHField;
+    fileContent << heightfieldField;
+    fileContent << occupancyField;
+    fileContent << pvsField;
+    fileContent << bspField;
     fileContent << "    .pathfinding = {.nodeCount = " << levelDef.pathfinding.mNodePositions.size() << ", .baseNodes = " << basePathNodePositions <<
-        ", .baseDistances = " << baseDist << ", .nodePositions = " << pathingNodePositions << ", .nextNode = " << nextNode << "}," << std::endl;
+        ", .baseDistances = " << baseDist << ", .nodePositions = " << pathingNodePositions << ", " << nextNodeFields << baseDistanceFields << navGraphFields << visibilityFields << "}," << std::endl;
+    fileContent << flowFields;
     fileContent << "};" << std::endl;
     fileContent << std::endl;
 }
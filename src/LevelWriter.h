@@ -2,9 +2,13 @@
 #define _LEVEL_WRITER_H
 
 #include <vector>
+#include <memory>
 #include <assimp/scene.h>
 #include "./DisplayListSettings.h"
 #include "Pathfinding.h"
+#include "Collision.h"
+#include "TriangleBVH.h"
+#include "Heightfield.h"
 
 class ThemeWriter;
 
@@ -27,13 +31,22 @@ class LevelDefinition {
 public:
     std::vector<BaseDefinition> bases;
     std::vector<aiMesh*> geometryMeshes;
+    // meshes made by the level writer that replace the scene meshes in geometryMeshes
+    std::vector<std::unique_ptr<aiMesh>> ownedGeometryMeshes;
+    // three points per triangle of the geometry meshes in level space, with the node
+    // transform applied like the bases and boundary but without mScale or mRotateModel
+    std::vector<aiVector3D> geometryTriangles;
     aiVector3D startPosition[MAX_PLAYERS];
     unsigned maxPlayerCount;
     aiVector3D minBoundary;
     aiVector3D maxBoundary;
     std::vector<aiVector3D> boundary;
     std::vector<DecorDefinition> decor;
+    Pathfinding pathingGraph;
     PathfindingDefinition pathfinding;
+    FlowFieldDefinition flowFields;
+    BoundaryDistanceField boundaryDistance;
+    Heightfield heightfield;
 };
 
 void generateLevelFromSceneToFile(const aiScene* scene, std::string filename, ThemeWriter* theme, DisplayListSettings& settings);
@@ -8,4 +8,17 @@ aiVector3D min(const aiVector3D& a, const aiVector3D& b) {
 
 aiVector3D max(const aiVector3D& a, const aiVector3D& b) {
     return aiVector3D(std::max(a.x, b.x), std::max(a.y, b.y), std::max(a.z, b.z));
-}
\ No newline at end of file
+}
+
+void toFixedPointMatrix(const aiMatrix4x4& transform, unsigned result[16]) {
+    for (unsigned row = 0; row < 4; ++row) {
+        for (unsigned col = 0; col < 4; col += 2) {
+            // the N64 multiplies row vectors so the matrix is transposed
+            unsigned first = (unsigned)(int)floorf(transform[col][row] * 65536.0f + 0.5f);
+            unsigned second = (unsigned)(int)floorf(transform[col + 1][row] * 65536.0f + 0.5f);
+
+            result[row * 2 + col / 2] = (first & 0xFFFF0000) | (second >> 16);
+            result[8 + row * 2 + col / 2] = (first << 16) | (second & 0xFFFF);
+        }
+    }
+}
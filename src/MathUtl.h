@@ -6,4 +6,7 @@
 aiVector3D min(const aiVector3D& a, const aiVector3D& b);
 aiVector3D max(const aiVector3D& a, const aiVector3D& b);
 
+// converts to the layout of an N64 Mtx, the integer halves of every element followed by the fractional halves
+void toFixedPointMatrix(const aiMatrix4x4& transform, unsigned result[16]);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,135 @@
+#include "OccupancyGrid.h"
+
+#include <math.h>
+#include <algorithm>
+#include "Collision.h"
+
+OccupancyGrid::OccupancyGrid(const aiVector3D& minBoundary, const aiVector3D& maxBoundary, float cellSize):
+    mMin(minBoundary),
+    mCellSize(cellSize),
+    mWidth(std::max((unsigned)ceilf((maxBoundary.x - minBoundary.x) / cellSize), 1u)),
+    mHeight(std::max((unsigned)ceilf((maxBoundary.z - minBoundary.z) / cellSize), 1u)),
+    mCells(mWidth * mHeight) {
+
+}
+
+void OccupancyGrid::GetCellRange(const aiVector3D& min, const aiVector3D& max, int& minX, int& minZ, int& maxX, int& maxZ) const {
+    minX = std::max(0, (int)floorf((min.x - mMin.x) / mCellSize));
+    minZ = std::max(0, (int)floorf((min.z - mMin.z) / mCellSize));
+    maxX = std::min((int)mWidth - 1, (int)floorf((max.x - mMin.x) / mCellSize));
+    maxZ = std::min((int)mHeight - 1, (int)floorf((max.z - mMin.z) / mCellSize));
+}
+
+void OccupancyGrid::MarkEdges(const std::vector<aiVector3D>& loop) {
+    for (unsigned i = 0; i < loop.size(); ++i) {
+        const aiVector3D& from = loop[i];
+        const aiVector3D& to = loop[(i + 1) % loop.size()];
+
+        int minX, minZ, maxX, maxZ;
+        GetCellRange(
+            aiVector3D(std::min(from.x, to.x), 0.0f, std::min(from.z, to.z)), 
+            aiVector3D(std::max(from.x, to.x), 0.0f, std::max(from.z, to.z)), 
+            minX, minZ, maxX, maxZ
+        );
+
+        for (int z = minZ; z <= maxZ; ++z) {
+            for (int x = minX; x <= maxX; ++x) {
+                aiVector3D cellMin(mMin.x + x * mCellSize, 0.0f, mMin.z + z * mCellSize);
+                aiVector3D cellMax(cellMin.x + mCellSize, 0.0f, cellMin.z + mCellSize);
+
+                if (doesSegmentTouchRectXZ(from, to, cellMin, cellMax)) {
+                    mCells[z * mWidth + x] = true;
+                }
+            }
+        }
+    }
+}
+
+void OccupancyGrid::MarkPolygon(const std::vector<aiVector3D>& loop) {
+    if (loop.empty()) {
+        return;
+    }
+
+    aiVector3D min = loop[0];
+    aiVector3D max = loop[0];
+
+    for (auto& point : loop) {
+        min.x = std::min(min.x, point.x); min.z = std::min(min.z, point.z);
+        max.x = std::max(max.x, point.x); max.z = std::max(max.z, point.z);
+    }
+
+    MarkEdges(loop);
+
+    int minX, minZ, maxX, maxZ;
+    GetCellRange(min, max, minX, minZ, maxX, maxZ);
+
+    for (int z = minZ; z <= maxZ; ++z) {
+        for (int x = minX; x <= maxX; ++x) {
+            aiVector3D center(mMin.x + (x + 0.5f) * mCellSize, 0.0f, mMin.z + (z + 0.5f) * mCellSize);
+
+            if (isInsideBoundary(center, loop)) {
+                mCells[z * mWidth + x] = true;
+            }
+        }
+    }
+}
+
+void OccupancyGrid::MarkCircle(const aiVector3D& center, float radius) {
+    int minX, minZ, maxX, maxZ;
+    GetCellRange(center - aiVector3D(radius, 0.0f, radius), center + aiVector3D(radius, 0.0f, radius), minX, minZ, maxX, maxZ);
+
+    for (int z = minZ; z <= maxZ; ++z) {
+        for (int x = minX; x <= maxX; ++x) {
+            float cellX = mMin.x + x * mCellSize;
+            float cellZ = mMin.z + z * mCellSize;
+
+            float offsetX = std::max(cellX, std::min(center.x, cellX + mCellSize)) - center.x;
+            float offsetZ = std::max(cellZ, std::min(center.z, cellZ + mCellSize)) - center.z;
+
+            if (offsetX * offsetX + offsetZ * offsetZ <= radius * radius) {
+                mCells[z * mWidth + x] = true;
+            }
+        }
+    }
+}
+
+void OccupancyGrid::MarkOutsideBoundary(const std::vector<aiVector3D>& boundary) {
+    if (boundary.empty()) {
+        return;
+    }
+
+    MarkEdges(boundary);
+
+    for (unsigned z = 0; z < mHeight; ++z) {
+        for (unsigned x = 0; x < mWidth; ++x) {
+            aiVector3D center(mMin.x + (x + 0.5f) * mCellSize, 0.0f, mMin.z + (z + 0.5f) * mCellSize);
+
+            if (!isInsideBoundary(center, boundary)) {
+                mCells[z * mWidth + x] = true;
+            }
+        }
+    }
+}
+
+unsigned OccupancyGrid::RowWords() const {
+    return (mWidth + 31) / 32;
+}
+
+std::vector<unsigned> OccupancyGrid::PackBits() const {
+    unsigned rowWords = RowWords();
+    std::vector<unsigned> result(rowWords * mHeight);
+
+    for (unsigned z = 0; z < mHeight; ++z) {
+        for (unsigned x = 0; x < mWidth; ++x) {
+            if (mCells[z * mWidth + x]) {
+                result[z * rowWords + x / 32] |= 1u << (x % 32);
+            }
+        }
+    }
+
+    return result;
+}
+
+unsigned OccupancyGrid::OccupiedCount() const {
+    return std::count(mCells.begin(), mCells.end(), true);
+}
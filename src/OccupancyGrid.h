@@ -0,0 +1,32 @@
+#ifndef _OCCUPANCY_GRID_H
+#define _OCCUPANCY_GRID_H
+
+#include <assimp/mesh.h>
+#include <vector>
+
+class OccupancyGrid {
+public:
+    OccupancyGrid(const aiVector3D& minBoundary, const aiVector3D& maxBoundary, float cellSize);
+
+    // marks every cell the loop overlaps
+    void MarkPolygon(const std::vector<aiVector3D>& loop);
+    void MarkCircle(const aiVector3D& center, float radius);
+    // marks cells that are not entirely inside the boundary
+    void MarkOutsideBoundary(const std::vector<aiVector3D>& boundary);
+
+    unsigned RowWords() const;
+    // each row is packed into RowWords() words with the lowest bit being the smallest x
+    std::vector<unsigned> PackBits() const;
+    unsigned OccupiedCount() const;
+
+    aiVector3D mMin;
+    float mCellSize;
+    unsigned mWidth;
+    unsigned mHeight;
+    std::vector<bool> mCells;
+private:
+    void GetCellRange(const aiVector3D& min, const aiVector3D& max, int& minX, int& minZ, int& maxX, int& maxZ) const;
+    void MarkEdges(const std::vector<aiVector3D>& loop);
+};
+
+#endif
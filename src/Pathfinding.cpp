@@ -1,124 +1,83 @@
 #include "Pathfinding.h"
+#include "Collision.h"
 #include <math.h>
+#include <queue>
+#include <functional>
+#include <unordered_map>
+#include <thread>
+#include <atomic>
+#include <iostream>
 
 bool shouldUsePathingPoint(float minY, const aiVector3D& point) {
     return std::abs(minY - point.y) < 0.5f;
 }
 
-std::vector<int> getAdjacentIndices(const std::set<std::pair<unsigned, unsigned>>& nodeConnections, const unsigned& adjTo){
-    std::vector<int> out;
-    for(auto node : nodeConnections){
-        if(node.first == adjTo) out.push_back(node.second);
+void Pathfinding::BuildAdjacency() {
+    mAdjacencyStart.clear();
+    mAdjacentNodes.clear();
+    mEdgeLengths.clear();
+
+    mAdjacencyStart.resize(mPathingNodes.size() + 1, 0);
+    mAdjacentNodes.reserve(mNodeConnections.size());
+    mEdgeLengths.reserve(mNodeConnections.size());
+
+    // mNodeConnections is sorted by the first node so neighbors end up contiguous
+    for (auto connection : mNodeConnections) {
+        ++mAdjacencyStart[connection.first + 1];
+        mAdjacentNodes.push_back(connection.second);
+        mEdgeLengths.push_back((mPathingNodes[connection.second] - mPathingNodes[connection.first]).Length());
     }
-    return out;
-}
 
-int getShortestPath(const std::vector<NavPath*>& allPaths, float& outDist){
-    if(allPaths.size() == 0) return -1;
-    else{
-        float minDist = allPaths[0]->len;
-        int minInd = 0;
-        for(unsigned i = 1; i < allPaths.size(); ++i){
-            if(allPaths[i]->reachesEndPoint){
-               if(allPaths[i]->len < minDist){
-                   minInd = i;
-                   minDist = allPaths[i]->len;
-               }
-            }
-        }
-        outDist = minDist;
-        return minInd;
+    for (unsigned i = 0; i < mPathingNodes.size(); ++i) {
+        mAdjacencyStart[i + 1] += mAdjacencyStart[i];
     }
 }
 
-void getPossiblePaths(unsigned from, unsigned to, const std::vector<aiVector3D>& nodePositions, const std::set<std::pair<unsigned, unsigned>>& nodeConnections, std::vector<NavPath*>& outPaths, const int& initialPath = -1){
+// single source dijkstra over the directed node connections
+// nextNode[to] is the first node to step to when going from 'from' to 'to'
+// unreachable nodes are given a next node of 'from' and a distance of NO_PATH_DISTANCE
+void findShortestPaths(unsigned from, const Pathfinding& graph, int* nextNode, float* distance) {
+    unsigned numPoints = graph.mPathingNodes.size();
 
-    if(from == to){
-        if(initialPath != -1){
-            outPaths[initialPath]->reachesEndPoint = true;
-        }
-        return;
+    for (unsigned i = 0; i < numPoints; ++i) {
+        nextNode[i] = from;
+        distance[i] = NO_PATH_DISTANCE;
     }
 
-    std::vector<int> branches = getAdjacentIndices(nodeConnections, from);
-    for(unsigned i = 0; i < branches.size(); ++i){
-        int adjInd = branches[i];
-
-        float distance = (nodePositions[adjInd] - nodePositions[from]).Length();
-
-        //when the initialPath value is equal to 1, it means that we have just started to observe paths, and thus don't have any branches in the outPaths array yet.
-        if(initialPath == -1){
-            NavPath* newPath = new NavPath();
-            newPath->points.push_back(from);
-            newPath->points.push_back(adjInd);
-            newPath->len = distance;
-            outPaths.push_back(newPath);
-            getPossiblePaths(adjInd, to, nodePositions, nodeConnections, outPaths, (outPaths.size()-1));
-        } 
-        else{
-            //the first branch will be just a continuation of the given path
-            if(i == 0){
-                if(!std::count(outPaths[initialPath]->points.begin(), outPaths[initialPath]->points.end(), adjInd)){
-
-                    outPaths[initialPath]->points.push_back(adjInd);
-                    outPaths[initialPath]->len += distance;
-                    
-                    getPossiblePaths(adjInd, to, nodePositions, nodeConnections, outPaths, initialPath);
-                }
-            }
-            //while all further branches will be observed as completely separate paths
-            else{
-                if(!std::count(outPaths[initialPath]->points.begin(), outPaths[initialPath]->points.end(), adjInd)){ //making sure that we're not moving in a circle
-                    //first, we duplicate the existing branch
-                    NavPath* newPath = new NavPath();
-                    newPath->points = outPaths[initialPath]->points;
-                    newPath->len = outPaths[initialPath]->len;
+    distance[from] = 0.0f;
 
-                    //and then append the data that we've just collected about this new branch
-                    newPath->points.push_back(adjInd);
-                    newPath->len += distance;
-                    outPaths.push_back(newPath);
+    typedef std::pair<float, unsigned> QueueEntry;
+    std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> queue;
+    queue.push(std::make_pair(0.0f, from));
 
-                    getPossiblePaths(adjInd, to, nodePositions, nodeConnections, outPaths, (outPaths.size()-1));
-                }
+    while (!queue.empty()) {
+        QueueEntry current = queue.top();
+        queue.pop();
+
+        unsigned node = current.second;
+
+        if (current.first > distance[node]) {
+            continue;
+        }
+
+        for (unsigned edge = graph.mAdjacencyStart[node]; edge < graph.mAdjacencyStart[node + 1]; ++edge) {
+            unsigned adjInd = graph.mAdjacentNodes[edge];
+            float newDistance = distance[node] + graph.mEdgeLengths[edge];
+
+            if (newDistance < distance[adjInd]) {
+                distance[adjInd] = newDistance;
+                nextNode[adjInd] = node == from ? adjInd : nextNode[node];
+                queue.push(std::make_pair(newDistance, adjInd));
             }
         }
-        
     }
-    
 }
 
-unsigned getNextPathPointIndex(unsigned from, unsigned to, const std::vector<aiVector3D>& nodePositions, const std::set<std::pair<unsigned, unsigned>>& nodeConnections, float& distance, const std::vector<int>& basesIndeces, std::vector<basesDistance>& baseDistances){
-
-    if(from == to){
-        distance = 0.f;
-        return from;
-    }
-    else{
-        std::vector<NavPath*> allPaths;
-        getPossiblePaths(from , to, nodePositions, nodeConnections, allPaths);
-
-        float shortestPathDist = 0.f;
-        int shortestPath = getShortestPath(allPaths, shortestPathDist);
-        distance = shortestPathDist;
-
-        if(std::count(basesIndeces.begin(), basesIndeces.end(), from) &&
-         std::count(basesIndeces.begin(), basesIndeces.end(), to)){
-             basesDistance newDist;
-             newDist.fromBase = from;
-             newDist.toBase = to;
-             newDist.distance = distance;
-             baseDistances.push_back(newDist);
-         }
-
-        unsigned result = allPaths[shortestPath]->points[1];
-        allPaths.clear();
-        return result;
-    }
-    
+long long weldGridKey(int x, int y, int z) {
+    return ((long long)(x & 0x1FFFFF) << 42) | ((long long)(y & 0x1FFFFF) << 21) | (long long)(z & 0x1FFFFF);
 }
 
-void buildPathingFromMesh(aiMesh* mesh, Pathfinding& result, const aiMatrix4x4& transform) {
+void buildPathingFromMesh(aiMesh* mesh, Pathfinding& result, const aiMatrix4x4& transform, float weldDistance) {
     std::vector<aiVector3D> transformed;
 
     for (unsigned i = 0; i < mesh->mNumVertices; ++i) {
@@ -130,31 +89,53 @@ void buildPathingFromMesh(aiMesh* mesh, Pathfinding& result, const aiMatrix4x4&
         minY = std::min(minY, transformed[i].y);
     }
 
-    std::map<unsigned, unsigned> mIndexMapping;
+    std::vector<int> indexMapping(mesh->mNumVertices, -1);
+
+    // bucket candidate points into a grid with cells the size of the weld distance
+    // so any duplicate of a point has to be in one of the 27 surrounding cells
+    float cellSize = std::max(weldDistance, 0.0001f);
+    float weldDistanceSqrd = weldDistance * weldDistance;
+    std::unordered_map<long long, std::vector<unsigned>> weldGrid;
 
     for (unsigned i = 0; i < mesh->mNumVertices; ++i) {
-        if (shouldUsePathingPoint(minY, transformed[i])) {
-            bool didFindDuplicate = false;
+        if (!shouldUsePathingPoint(minY, transformed[i])) {
+            continue;
+        }
 
-            for (unsigned dupeCheck = 0; dupeCheck < i; ++dupeCheck) {
-                if (!shouldUsePathingPoint(minY, transformed[dupeCheck])) {
-                    continue;
-                }
+        int cellX = (int)floorf(transformed[i].x / cellSize);
+        int cellY = (int)floorf(transformed[i].y / cellSize);
+        int cellZ = (int)floorf(transformed[i].z / cellSize);
 
-                float dist = (transformed[i] - transformed[dupeCheck]).SquareLength();
+        // find the lowest index within the weld distance to match
+        // the order the duplicates were checked in before
+        int duplicate = -1;
 
-                if (dist < 0.001f) {
-                    mIndexMapping[i] = mIndexMapping[dupeCheck];
-                    didFindDuplicate = true;
-                    break;
+        for (int x = cellX - 1; x <= cellX + 1; ++x) {
+            for (int y = cellY - 1; y <= cellY + 1; ++y) {
+                for (int z = cellZ - 1; z <= cellZ + 1; ++z) {
+                    auto cell = weldGrid.find(weldGridKey(x, y, z));
+
+                    if (cell == weldGrid.end()) {
+                        continue;
+                    }
+
+                    for (auto dupeCheck : cell->second) {
+                        if ((duplicate == -1 || (int)dupeCheck < duplicate) && (transformed[i] - transformed[dupeCheck]).SquareLength() < weldDistanceSqrd) {
+                            duplicate = dupeCheck;
+                        }
+                    }
                 }
             }
-            
-            if (!didFindDuplicate) {
-                mIndexMapping[i] = result.mPathingNodes.size();
-                result.mPathingNodes.push_back(transformed[i]);
-            }
         }
+
+        if (duplicate != -1) {
+            indexMapping[i] = indexMapping[duplicate];
+        } else {
+            indexMapping[i] = result.mPathingNodes.size();
+            result.mPathingNodes.push_back(transformed[i]);
+        }
+
+        weldGrid[weldGridKey(cellX, cellY, cellZ)].push_back(i);
     }
 
     for (unsigned faceIndex = 0; faceIndex < mesh->mNumFaces; ++faceIndex) {
@@ -164,14 +145,13 @@ void buildPathingFromMesh(aiMesh* mesh, Pathfinding& result, const aiMatrix4x4&
             unsigned curr = face->mIndices[vertexIndex];
             unsigned next = face->mIndices[(vertexIndex + 1) % face->mNumIndices];
 
-            auto currMapping = mIndexMapping.find(curr);
-            auto nextMapping = mIndexMapping.find(next);
-
-            if (currMapping != mIndexMapping.end() && nextMapping != mIndexMapping.end()) {
-                result.mNodeConnections.insert(std::make_pair(currMapping->second, nextMapping->second));
+            if (indexMapping[curr] != -1 && indexMapping[next] != -1) {
+                result.mNodeConnections.insert(std::make_pair(indexMapping[curr], indexMapping[next]));
             }
         }
     }
+
+    result.BuildAdjacency();
 }
 
 unsigned getClosestLocationInd(const aiVector3D& closestTo, const std::vector<aiVector3D>& allPos){
@@ -191,7 +171,579 @@ unsigned getClosestLocationInd(const aiVector3D& closestTo, const std::vector<ai
     }
 }
 
-void buildPathfindingDefinition(const Pathfinding& from, PathfindingDefinition& result, const std::vector<aiVector3D>& basePositions) {
+float distanceToSegmentXZ(const aiVector3D& point, const aiVector3D& from, const aiVector3D& to) {
+    aiVector3D offset = to - from;
+    aiVector3D relative = point - from;
+    offset.y = 0.0f;
+    relative.y = 0.0f;
+
+    float lerp = offset.SquareLength() > 0.0f ? (relative * offset) / offset.SquareLength() : 0.0f;
+    lerp = std::max(0.0f, std::min(1.0f, lerp));
+
+    return (relative - offset * lerp).Length();
+}
+
+bool isShortcutBlocked(const aiVector3D& from, const aiVector3D& to, const std::vector<aiVector3D>& boundary, const std::vector<std::vector<aiVector3D>>& obstacles) {
+    if (!boundary.empty() && doesSegmentCrossBoundary(from, to, boundary)) {
+        return true;
+    }
+
+    for (auto& obstacle : obstacles) {
+        // a segment that doesn't touch the edges can still be entirely inside
+        if (doesSegmentCrossBoundary(from, to, obstacle) || isInsideBoundary((from + to) * 0.5f, obstacle)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void simplifyPathing(Pathfinding& graph, const std::vector<aiVector3D>& boundary, const std::vector<std::vector<aiVector3D>>& obstacles, const std::vector<aiVector3D>& keepPositions, float tolerance) {
+    unsigned numPoints = graph.mPathingNodes.size();
+
+    if (numPoints == 0) {
+        return;
+    }
+
+    std::vector<std::set<unsigned>> incoming(numPoints);
+    std::vector<std::set<unsigned>> outgoing(numPoints);
+
+    for (auto connection : graph.mNodeConnections) {
+        if (connection.first != connection.second) {
+            outgoing[connection.first].insert(connection.second);
+            incoming[connection.second].insert(connection.first);
+        }
+    }
+
+    std::vector<bool> keep(numPoints, false);
+
+    for (auto& position : keepPositions) {
+        keep[getClosestLocationInd(position, graph.mPathingNodes)] = true;
+    }
+
+    std::vector<bool> removed(numPoints, false);
+
+    for (unsigned node = 0; node < numPoints; ++node) {
+        if (keep[node] || incoming[node].empty() || outgoing[node].empty()) {
+            continue;
+        }
+
+        // every way through this node has to be replaced with a direct connection
+        std::vector<std::pair<unsigned, unsigned>> shortcuts;
+        bool canRemove = true;
+
+        for (auto from : incoming[node]) {
+            for (auto to : outgoing[node]) {
+                if (from == to || outgoing[from].count(to)) {
+                    continue;
+                }
+
+                const aiVector3D& fromPos = graph.mPathingNodes[from];
+                const aiVector3D& toPos = graph.mPathingNodes[to];
+
+                // a shortcut through a wall or decor is never allowed, even if it barely moves the path
+                if (distanceToSegmentXZ(graph.mPathingNodes[node], fromPos, toPos) > tolerance || isShortcutBlocked(fromPos, toPos, boundary, obstacles)) {
+                    canRemove = false;
+                    break;
+                }
+
+                shortcuts.push_back(std::make_pair(from, to));
+            }
+
+            if (!canRemove) {
+                break;
+            }
+        }
+
+        // don't let the graph get any denser than it already is
+        if (!canRemove || shortcuts.size() > incoming[node].size() + outgoing[node].size()) {
+            continue;
+        }
+
+        for (auto from : incoming[node]) {
+            outgoing[from].erase(node);
+        }
+
+        for (auto to : outgoing[node]) {
+            incoming[to].erase(node);
+        }
+
+        for (auto shortcut : shortcuts) {
+            outgoing[shortcut.first].insert(shortcut.second);
+            incoming[shortcut.second].insert(shortcut.first);
+        }
+
+        incoming[node].clear();
+        outgoing[node].clear();
+        removed[node] = true;
+    }
+
+    std::vector<unsigned> indexMapping(numPoints);
+    std::vector<aiVector3D> remainingNodes;
+
+    for (unsigned node = 0; node < numPoints; ++node) {
+        if (!removed[node]) {
+            indexMapping[node] = remainingNodes.size();
+            remainingNodes.push_back(graph.mPathingNodes[node]);
+        }
+    }
+
+    graph.mNodeConnections.clear();
+
+    for (unsigned node = 0; node < numPoints; ++node) {
+        for (auto to : outgoing[node]) {
+            graph.mNodeConnections.insert(std::make_pair(indexMapping[node], indexMapping[to]));
+        }
+    }
+
+    graph.mPathingNodes = remainingNodes;
+    graph.BuildAdjacency();
+
+    std::cout << "Simplified pathing from " << numPoints << " to " << remainingNodes.size() << " nodes" << std::endl;
+}
+
+unsigned PathfindingClusters::ClusterCount() const {
+    return mClusterNodeStart.size() ? mClusterNodeStart.size() - 1 : 0;
+}
+
+// splits the nodes of each grid cell into strongly connected components so
+// every node in a cluster can reach every other node without leaving the cluster
+void findStronglyConnected(const Pathfinding& graph, const std::vector<unsigned>& cell, std::vector<int>& component, unsigned& componentCount) {
+    unsigned numPoints = graph.mPathingNodes.size();
+    std::vector<std::vector<unsigned>> reverseEdges(numPoints);
+
+    for (unsigned node = 0; node < numPoints; ++node) {
+        for (unsigned edge = graph.mAdjacencyStart[node]; edge < graph.mAdjacencyStart[node + 1]; ++edge) {
+            unsigned adjInd = graph.mAdjacentNodes[edge];
+
+            if (cell[adjInd] == cell[node]) {
+                reverseEdges[adjInd].push_back(node);
+            }
+        }
+    }
+
+    // first pass records the order nodes finish in
+    std::vector<bool> visited(numPoints, false);
+    std::vector<unsigned> finishOrder;
+    std::vector<std::pair<unsigned, unsigned>> stack;
+
+    for (unsigned start = 0; start < numPoints; ++start) {
+        if (visited[start]) {
+            continue;
+        }
+
+        visited[start] = true;
+        stack.push_back(std::make_pair(start, graph.mAdjacencyStart[start]));
+
+        while (!stack.empty()) {
+            unsigned node = stack.back().first;
+            unsigned& edge = stack.back().second;
+
+            if (edge == graph.mAdjacencyStart[node + 1]) {
+                finishOrder.push_back(node);
+                stack.pop_back();
+                continue;
+            }
+
+            unsigned adjInd = graph.mAdjacentNodes[edge];
+            ++edge;
+
+            if (!visited[adjInd] && cell[adjInd] == cell[node]) {
+                visited[adjInd] = true;
+                stack.push_back(std::make_pair(adjInd, graph.mAdjacencyStart[adjInd]));
+            }
+        }
+    }
+
+    // second pass walks the reversed edges in reverse finish order
+    component.assign(numPoints, -1);
+    componentCount = 0;
+    std::vector<unsigned> toVisit;
+
+    for (auto it = finishOrder.rbegin(); it != finishOrder.rend(); ++it) {
+        if (component[*it] != -1) {
+            continue;
+        }
+
+        component[*it] = componentCount;
+        toVisit.push_back(*it);
+
+        while (!toVisit.empty()) {
+            unsigned node = toVisit.back();
+            toVisit.pop_back();
+
+            for (auto adjInd : reverseEdges[node]) {
+                if (component[adjInd] == -1) {
+                    component[adjInd] = componentCount;
+                    toVisit.push_back(adjInd);
+                }
+            }
+        }
+
+        ++componentCount;
+    }
+}
+
+void buildPathfindingClusters(const Pathfinding& from, PathfindingClusters& result, unsigned clusterSize) {
+    unsigned numPoints = from.mPathingNodes.size();
+
+    if (numPoints == 0) {
+        return;
+    }
+
+    aiVector3D minPos = from.mPathingNodes[0];
+    aiVector3D maxPos = from.mPathingNodes[0];
+
+    for (auto& node : from.mPathingNodes) {
+        minPos.x = std::min(minPos.x, node.x);
+        minPos.z = std::min(minPos.z, node.z);
+        maxPos.x = std::max(maxPos.x, node.x);
+        maxPos.z = std::max(maxPos.z, node.z);
+    }
+
+    unsigned gridSize = (unsigned)ceilf(sqrtf((float)numPoints / std::max(clusterSize, 1u)));
+    gridSize = std::max(gridSize, 1u);
+
+    std::vector<unsigned> cell(numPoints);
+
+    for (unsigned i = 0; i < numPoints; ++i) {
+        float relX = (maxPos.x > minPos.x) ? (from.mPathingNodes[i].x - minPos.x) / (maxPos.x - minPos.x) : 0.0f;
+        float relZ = (maxPos.z > minPos.z) ? (from.mPathingNodes[i].z - minPos.z) / (maxPos.z - minPos.z) : 0.0f;
+        unsigned cellX = std::min((unsigned)(relX * gridSize), gridSize - 1);
+        unsigned cellZ = std::min((unsigned)(relZ * gridSize), gridSize - 1);
+        cell[i] = cellX + cellZ * gridSize;
+    }
+
+    std::vector<int> component;
+    unsigned clusterCount;
+    findStronglyConnected(from, cell, component, clusterCount);
+
+    result.mNodeCluster.resize(numPoints);
+    result.mNodeLocalIndex.resize(numPoints);
+    result.mClusterNodeStart.assign(clusterCount + 1, 0);
+
+    for (unsigned i = 0; i < numPoints; ++i) {
+        result.mNodeCluster[i] = component[i];
+        ++result.mClusterNodeStart[component[i] + 1];
+    }
+
+    for (unsigned cluster = 0; cluster < clusterCount; ++cluster) {
+        result.mClusterNodeStart[cluster + 1] += result.mClusterNodeStart[cluster];
+    }
+
+    result.mClusterNodes.resize(numPoints);
+    std::vector<unsigned> clusterFill(result.mClusterNodeStart.begin(), result.mClusterNodeStart.end() - 1);
+
+    for (unsigned i = 0; i < numPoints; ++i) {
+        unsigned cluster = result.mNodeCluster[i];
+        result.mNodeLocalIndex[i] = clusterFill[cluster] - result.mClusterNodeStart[cluster];
+        result.mClusterNodes[clusterFill[cluster]] = i;
+        ++clusterFill[cluster];
+    }
+
+    // each cluster gets its own small graph to build its next node table from
+    // and the clusters themselves form a graph connected by the edges between them
+    Pathfinding clusterGraph;
+    std::map<std::pair<unsigned, unsigned>, std::pair<unsigned, unsigned>> clusterExits;
+    std::map<std::pair<unsigned, unsigned>, float> clusterExitCost;
+
+    for (unsigned cluster = 0; cluster < clusterCount; ++cluster) {
+        unsigned start = result.mClusterNodeStart[cluster];
+        unsigned nodeCount = result.mClusterNodeStart[cluster + 1] - start;
+
+        Pathfinding localGraph;
+        aiVector3D center;
+
+        for (unsigned local = 0; local < nodeCount; ++local) {
+            localGraph.mPathingNodes.push_back(from.mPathingNodes[result.mClusterNodes[start + local]]);
+            center += from.mPathingNodes[result.mClusterNodes[start + local]];
+        }
+
+        clusterGraph.mPathingNodes.push_back(center / (float)nodeCount);
+
+        for (unsigned local = 0; local < nodeCount; ++local) {
+            unsigned node = result.mClusterNodes[start + local];
+
+            for (unsigned edge = from.mAdjacencyStart[node]; edge < from.mAdjacencyStart[node + 1]; ++edge) {
+                unsigned adjInd = from.mAdjacentNodes[edge];
+
+                if (result.mNodeCluster[adjInd] == cluster) {
+                    localGraph.mNodeConnections.insert(std::make_pair(local, result.mNodeLocalIndex[adjInd]));
+                }
+            }
+        }
+
+        localGraph.BuildAdjacency();
+
+        result.mClusterTableStart.push_back(result.mClusterNextNode.size());
+
+        std::vector<int> nextNode(nodeCount);
+        std::vector<float> distance(nodeCount);
+
+        for (unsigned local = 0; local < nodeCount; ++local) {
+            findShortestPaths(local, localGraph, nextNode.data(), distance.data());
+            result.mClusterNextNode.insert(result.mClusterNextNode.end(), nextNode.begin(), nextNode.end());
+        }
+    }
+
+    for (unsigned node = 0; node < numPoints; ++node) {
+        unsigned cluster = result.mNodeCluster[node];
+
+        for (unsigned edge = from.mAdjacencyStart[node]; edge < from.mAdjacencyStart[node + 1]; ++edge) {
+            unsigned adjInd = from.mAdjacentNodes[edge];
+            unsigned adjCluster = result.mNodeCluster[adjInd];
+
+            if (adjCluster == cluster) {
+                continue;
+            }
+
+            // prefer the edge between the clusters that is closest to the path between the cluster centers
+            std::pair<unsigned, unsigned> clusterPair = std::make_pair(cluster, adjCluster);
+            float cost = (from.mPathingNodes[node] - clusterGraph.mPathingNodes[cluster]).Length() +
+                from.mEdgeLengths[edge] +
+                (clusterGraph.mPathingNodes[adjCluster] - from.mPathingNodes[adjInd]).Length();
+
+            auto existing = clusterExitCost.find(clusterPair);
+
+            if (existing == clusterExitCost.end() || cost < existing->second) {
+                clusterExitCost[clusterPair] = cost;
+                clusterExits[clusterPair] = std::make_pair(node, adjInd);
+            }
+
+            clusterGraph.mNodeConnections.insert(clusterPair);
+        }
+    }
+
+    clusterGraph.BuildAdjacency();
+
+    result.mClusterExit.assign(clusterCount * clusterCount, numPoints);
+    result.mClusterExitNext.assign(clusterCount * clusterCount, numPoints);
+
+    std::vector<int> nextCluster(clusterCount);
+    std::vector<float> clusterDistance(clusterCount);
+
+    for (unsigned cluster = 0; cluster < clusterCount; ++cluster) {
+        findShortestPaths(cluster, clusterGraph, nextCluster.data(), clusterDistance.data());
+
+        for (unsigned target = 0; target < clusterCount; ++target) {
+            if (target == cluster || clusterDistance[target] == NO_PATH_DISTANCE) {
+                continue;
+            }
+
+            auto exit = clusterExits[std::make_pair(cluster, (unsigned)nextCluster[target])];
+            result.mClusterExit[cluster * clusterCount + target] = exit.first;
+            result.mClusterExitNext[cluster * clusterCount + target] = exit.second;
+        }
+    }
+}
+
+void buildNextNodeTable(const Pathfinding& from, PathfindingDefinition& result, unsigned threadCount) {
+    unsigned int numPoints = from.mPathingNodes.size();
+
+    result.mNextNode.resize(numPoints * numPoints);
+    result.mDistToNode.resize(numPoints * numPoints);
+
+    // each row only depends on its source node so the rows
+    // are split between threads with each thread writing its own rows
+    std::atomic<unsigned> nextSource(0);
+
+    auto processSources = [&]() {
+        for (unsigned x = nextSource++; x < numPoints; x = nextSource++) {
+            findShortestPaths(x, from, &result.mNextNode[x * numPoints], &result.mDistToNode[x * numPoints]);
+        }
+    };
+
+    if (threadCount == 0) {
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    threadCount = std::min(threadCount, std::max(numPoints, 1u));
+
+    std::vector<std::thread> workers;
+
+    for (unsigned i = 1; i < threadCount; ++i) {
+        workers.push_back(std::thread(processSources));
+    }
+
+    processSources();
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void buildDistanceFields(const Pathfinding& from, const std::vector<int>& targets, std::vector<float>& result) {
+    unsigned int numPoints = from.mPathingNodes.size();
+
+    // searching from the target over the reversed connections gives
+    // the distance from every node to the target
+    Pathfinding reversed;
+    reversed.mPathingNodes = from.mPathingNodes;
+
+    for (auto connection : from.mNodeConnections) {
+        reversed.mNodeConnections.insert(std::make_pair(connection.second, connection.first));
+    }
+
+    reversed.BuildAdjacency();
+
+    std::vector<int> nextNode(numPoints);
+    result.resize(targets.size() * numPoints);
+
+    for (unsigned target = 0; target < targets.size(); ++target) {
+        findShortestPaths(targets[target], reversed, nextNode.data(), &result[target * numPoints]);
+    }
+}
+
+void buildBaseDistances(const Pathfinding& from, PathfindingDefinition& result, bool includeDistanceFields) {
+    unsigned int numPoints = from.mPathingNodes.size();
+
+    if (numPoints == 0) {
+        return;
+    }
+
+    std::set<int> baseNodeSet(result.baseNodes.begin(), result.baseNodes.end());
+
+    std::vector<int> nextNode(numPoints);
+    std::vector<float> distance(numPoints);
+
+    for (auto x : baseNodeSet) {
+        findShortestPaths(x, from, nextNode.data(), distance.data());
+
+        for (auto y : baseNodeSet) {
+            if (x == y) {
+                continue;
+            }
+
+            basesDistance newDist;
+            newDist.fromBase = x;
+            newDist.toBase = y;
+            newDist.distance = distance[y];
+            result.baseDistances.push_back(newDist);
+        }
+    }
+
+    if (includeDistanceFields) {
+        buildDistanceFields(from, result.baseNodes, result.mBaseDistanceFields);
+    }
+}
+
+unsigned PathfindingDefinition::VisibilityRowWords() const {
+    return (mNodePositions.size() + 31) / 32;
+}
+
+void buildLineOfSight(PathfindingDefinition& result, const std::vector<aiVector3D>& basePositions, const std::vector<aiVector3D>& boundary) {
+    unsigned numPoints = result.mNodePositions.size();
+    unsigned rowWords = result.VisibilityRowWords();
+
+    result.mNodeVisibility.assign(numPoints * rowWords, 0);
+    result.mBaseVisibility.assign(basePositions.size() * rowWords, 0);
+
+    // nodes and bases often sit right on the boundary so touching it doesn't block sight
+    // visibility is symmetric so each pair is only checked once
+    for (unsigned from = 0; from < numPoints; ++from) {
+        for (unsigned to = from; to < numPoints; ++to) {
+            if (from == to || !doesSegmentLeaveBoundary(result.mNodePositions[from], result.mNodePositions[to], boundary)) {
+                result.mNodeVisibility[from * rowWords + to / 32] |= 1u << (to % 32);
+                result.mNodeVisibility[to * rowWords + from / 32] |= 1u << (from % 32);
+            }
+        }
+    }
+
+    for (unsigned base = 0; base < basePositions.size(); ++base) {
+        for (unsigned to = 0; to < numPoints; ++to) {
+            if (!doesSegmentLeaveBoundary(basePositions[base], result.mNodePositions[to], boundary)) {
+                result.mBaseVisibility[base * rowWords + to / 32] |= 1u << (to % 32);
+            }
+        }
+    }
+}
+
+void buildFlowFields(const Pathfinding& graph, const PathfindingDefinition& pathfinding, const std::vector<aiVector3D>& basePositions, const std::vector<aiVector3D>& boundary, const aiVector3D& minBoundary, const aiVector3D& maxBoundary, float cellSize, FlowFieldDefinition& result) {
+    unsigned numPoints = pathfinding.mNodePositions.size();
+
+    result.mMin = minBoundary;
+    result.mCellSize = cellSize;
+    result.mWidth = std::max((unsigned)ceilf((maxBoundary.x - minBoundary.x) / cellSize), 1u);
+    result.mHeight = std::max((unsigned)ceilf((maxBoundary.z - minBoundary.z) / cellSize), 1u);
+    result.mBaseCount = basePositions.size();
+
+    unsigned cellCount = result.mWidth * result.mHeight;
+    result.mDirections.assign(cellCount * basePositions.size(), FLOW_FIELD_NO_DIRECTION);
+
+    std::vector<float> distanceToBase;
+
+    if (numPoints) {
+        buildDistanceFields(graph, pathfinding.baseNodes, distanceToBase);
+    }
+
+    for (unsigned cell = 0; cell < cellCount; ++cell) {
+        aiVector3D center(
+            minBoundary.x + ((cell % result.mWidth) + 0.5f) * cellSize, 
+            0.0f, 
+            minBoundary.z + ((cell / result.mWidth) + 0.5f) * cellSize
+        );
+
+        if (!boundary.empty() && !isInsideBoundary(center, boundary)) {
+            continue;
+        }
+
+        // the nodes that can be walked to in a straight line are shared by every base
+        std::vector<unsigned> visibleNodes;
+
+        for (unsigned node = 0; node < numPoints; ++node) {
+            if (!doesSegmentCrossBoundary(center, pathfinding.mNodePositions[node], boundary)) {
+                visibleNodes.push_back(node);
+            }
+        }
+
+        for (unsigned base = 0; base < basePositions.size(); ++base) {
+            aiVector3D target = basePositions[base];
+
+            if (doesSegmentCrossBoundary(center, target, boundary)) {
+                float bestDistance = NO_PATH_DISTANCE;
+
+                for (auto node : visibleNodes) {
+                    float nodeDistance = distanceToBase[base * numPoints + node];
+
+                    float offset = (pathfinding.mNodePositions[node] - center).Length();
+
+                    // a node under the cell center gives no direction to steer in
+                    if (nodeDistance == NO_PATH_DISTANCE || offset < 0.001f) {
+                        continue;
+                    }
+
+                    nodeDistance += offset;
+
+                    if (nodeDistance < bestDistance) {
+                        bestDistance = nodeDistance;
+                        target = pathfinding.mNodePositions[node];
+                    }
+                }
+
+                if (bestDistance == NO_PATH_DISTANCE) {
+                    continue;
+                }
+            }
+
+            float dx = target.x - center.x;
+            float dz = target.z - center.z;
+
+            if (dx * dx + dz * dz < 0.00001f) {
+                continue;
+            }
+
+            float angle = atan2f(dz, dx);
+
+            if (angle < 0.0f) {
+                angle += 2.0f * M_PI;
+            }
+
+            result.mDirections[base * cellCount + cell] = (unsigned char)((unsigned)roundf(angle * FLOW_FIELD_DIRECTION_COUNT / (2.0f * M_PI)) % FLOW_FIELD_DIRECTION_COUNT);
+        }
+    }
+}
+
+void buildPathfindingDefinition(const Pathfinding& from, PathfindingDefinition& result, const std::vector<aiVector3D>& basePositions, const LevelSettings& settings, unsigned threadCount) {
 
     unsigned int numPoints = from.mPathingNodes.size();
 
@@ -201,22 +753,30 @@ void buildPathfindingDefinition(const Pathfinding& from, PathfindingDefinition&
 
     for(unsigned baseI = 0; baseI < basePositions.size(); ++baseI)
         result.baseNodes.push_back(getClosestLocationInd(basePositions[baseI], result.mNodePositions));
-    
-    result.mNextNode.reserve(numPoints * numPoints);
-    result.mDistToNode.reserve(numPoints * numPoints);
 
-    for(unsigned x = 0; x < result.mNodePositions.size(); ++x){
-        for(unsigned y = 0; y < result.mNodePositions.size(); ++y){
-            if(x == y){
-                result.mNextNode[x * numPoints + y] = x;
-                result.mDistToNode[x * numPoints + y] = 0.f;
-            } 
-            else{
-                std::set<int> processedNodes;
-                float distanceToNode = 0.f;
-                result.mNextNode[x * numPoints + y] = getNextPathPointIndex(x, y, result.mNodePositions, from.mNodeConnections, distanceToNode, result.baseNodes, result.baseDistances);
-                result.mDistToNode[x * numPoints + y] = distanceToNode;
-            }
+    if (settings.mPathfindingClusterSize) {
+        buildPathfindingClusters(from, result.mClusters, settings.mPathfindingClusterSize);
+
+        unsigned clusterCount = result.mClusters.ClusterCount();
+        unsigned exitTableSize = 2 * clusterCount * clusterCount;
+        // the per cluster tables, the exit tables, and the cluster and local index of each node
+        unsigned clusteredSize = result.mClusters.mClusterNextNode.size() + exitTableSize + 2 * numPoints;
+
+        std::cout << "Split " << numPoints << " pathing nodes into " << clusterCount << " clusters with " <<
+            exitTableSize << " cluster exit entries and " << clusteredSize << " entries in total" << std::endl;
+
+        // directed edges can split clusters into many tiny ones and the exit
+        // table grows with the square of the cluster count
+        if (clusteredSize >= numPoints * numPoints) {
+            std::cerr << "Clustered pathfinding needs " << clusteredSize << " entries which is more than the " <<
+                (numPoints * numPoints) << " of the full NextNode table, using the full table instead" << std::endl;
+            result.mClusters = PathfindingClusters();
         }
     }
-}
\ No newline at end of file
+
+    if (!result.mClusters.ClusterCount() && settings.mPathfindingNextNodeTable) {
+        buildNextNodeTable(from, result, threadCount);
+    }
+
+    buildBaseDistances(from, result, settings.mPathfindingBaseDistanceFields);
+}
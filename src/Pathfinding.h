@@ -5,12 +5,24 @@
 #include <vector>
 #include <map>
 #include <set>
+#include <limits>
+#include "LevelSettings.h"
+
+#define NO_PATH_DISTANCE std::numeric_limits<float>::max()
 
 class Pathfinding {
 public:
     std::vector<aiVector3D> mPathingNodes;
     // each element specifices a connection between to of the nodes in mPathingNodes as specified by its index
     std::set<std::pair<unsigned, unsigned>> mNodeConnections;
+    // compressed sparse row form of mNodeConnections, the nodes adjacent to node n are
+    // mAdjacentNodes[mAdjacencyStart[n]] up to but not including mAdjacentNodes[mAdjacencyStart[n + 1]]
+    // and mEdgeLengths holds the length of each of those connections
+    std::vector<unsigned> mAdjacencyStart;
+    std::vector<unsigned> mAdjacentNodes;
+    std::vector<float> mEdgeLengths;
+
+    void BuildAdjacency();
 };
 
 struct basesDistance{
@@ -19,11 +31,38 @@ struct basesDistance{
     float distance;
 };
 
+// pathing nodes grouped into spatial clusters where each cluster only stores
+// a next node table for its own nodes and moving between clusters goes through
+// the exit node for the pair of clusters
+class PathfindingClusters {
+public:
+    // cluster index and index within that cluster for each pathing node
+    std::vector<unsigned> mNodeCluster;
+    std::vector<unsigned> mNodeLocalIndex;
+    // the nodes of cluster c are mClusterNodes[mClusterNodeStart[c]] up to mClusterNodes[mClusterNodeStart[c + 1]]
+    std::vector<unsigned> mClusterNodeStart;
+    std::vector<unsigned> mClusterNodes;
+    // the next node table for cluster c with n nodes starts at mClusterNextNode[mClusterTableStart[c]]
+    // and has n * n entries that are local indices into the nodes of that cluster
+    std::vector<unsigned> mClusterTableStart;
+    std::vector<unsigned> mClusterNextNode;
+    // to get from cluster a to cluster b first go to node mClusterExit[a * clusterCount + b] using the
+    // table for cluster a then step to mClusterExitNext[a * clusterCount + b] which is in a neighboring cluster
+    // if there is no way to get to cluster b both entries are set to the node count
+    std::vector<unsigned> mClusterExit;
+    std::vector<unsigned> mClusterExitNext;
+
+    unsigned ClusterCount() const;
+};
+
 class PathfindingDefinition {
 public:
     std::vector<aiVector3D> mNodePositions;
     std::vector<int> baseNodes;
     std::vector<basesDistance> baseDistances;
+    // only filled in when base distance fields are enabled, for each entry in baseNodes
+    // there are mNodePositions.size() distances from each node to that base
+    std::vector<float> mBaseDistanceFields;
     // to be interpreted as a 2D array with mNodePositions.size() * mNodePositions.size() entries
     // If an AI agent wanted to go from node an index n to node at index m it would do so by looking up
     // the entry in mNextNode[from * mNodePositions.size() + to] and the result would be another index
@@ -32,20 +71,46 @@ public:
     // and lookup in mNextNode to get to the next node 
     std::vector<int> mNextNode;
     std::vector<float> mDistToNode;
-};
+    // used instead of mNextNode when the level uses clustered pathfinding
+    PathfindingClusters mClusters;
+    // bitsets with one row of VisibilityRowWords() words for each node and then for each base
+    // bit n of a row is set if the row's node or base has a clear line to node n
+    std::vector<unsigned> mNodeVisibility;
+    std::vector<unsigned> mBaseVisibility;
 
-class NavPath {
-    public:
-    std::vector<int> points;
-    float len = 0.f;
-    bool reachesEndPoint = false;
+    unsigned VisibilityRowWords() const;
 };
 
-//will return integers that appear to be in the given pairs set as the 'second' value
-//std::vector<int> getAdjacentIndices(const std::set<std::pair<unsigned, unsigned>>& nodeConnections, const unsigned& adjTo); 
+// direction for each cell of a grid over the level pointing along the shortest path to a base
+// directions are stored as an angle in the xz plane of value * 2 * pi / FLOW_FIELD_DIRECTION_COUNT
+// measured from the x axis towards the z axis. Valid directions are 0 to 254 so the last
+// value of a byte is free to mark cells with no path
+#define FLOW_FIELD_DIRECTION_COUNT  255
+#define FLOW_FIELD_NO_DIRECTION     FLOW_FIELD_DIRECTION_COUNT
+
+class FlowFieldDefinition {
+public:
+    aiVector3D mMin;
+    float mCellSize;
+    unsigned mWidth;
+    unsigned mHeight;
+    unsigned mBaseCount;
+    // mWidth * mHeight cells for each base, row by row starting at mMin
+    std::vector<unsigned char> mDirections;
+};
 
-void buildPathingFromMesh(aiMesh* mesh, Pathfinding& result, const aiMatrix4x4& transform);
-void buildPathfindingDefinition(const Pathfinding& from, PathfindingDefinition& result, const std::vector<aiVector3D>& basePositions);
-unsigned getNextPathPointIndex(unsigned from, unsigned to, const std::vector<aiVector3D>& nodePositions, const std::set<std::pair<unsigned, unsigned>>& nodeConnections, std::set<int>& nodesToIgnore, float& distance);
+// pathing points closer than weldDistance to each other are merged into a single node
+void buildPathingFromMesh(aiMesh* mesh, Pathfinding& result, const aiMatrix4x4& transform, float weldDistance);
+// removes nodes within tolerance of the straight line connecting their neighbors directly as long as that
+// line doesn't cross the boundary or any of the obstacle loops. nodes closest to keepPositions are never removed
+void simplifyPathing(Pathfinding& graph, const std::vector<aiVector3D>& boundary, const std::vector<std::vector<aiVector3D>>& obstacles, const std::vector<aiVector3D>& keepPositions, float tolerance);
+// distance from every node to each target, mPathingNodes.size() values for each target
+void buildDistanceFields(const Pathfinding& from, const std::vector<int>& targets, std::vector<float>& result);
+void buildFlowFields(const Pathfinding& graph, const PathfindingDefinition& pathfinding, const std::vector<aiVector3D>& basePositions, const std::vector<aiVector3D>& boundary, const aiVector3D& minBoundary, const aiVector3D& maxBoundary, float cellSize, FlowFieldDefinition& result);
+void buildLineOfSight(PathfindingDefinition& result, const std::vector<aiVector3D>& basePositions, const std::vector<aiVector3D>& boundary);
+// threadCount of 0 uses one thread per core
+void buildPathfindingDefinition(const Pathfinding& from, PathfindingDefinition& result, const std::vector<aiVector3D>& basePositions, const LevelSettings& settings, unsigned threadCount);
+// clusterSize is the average number of nodes to put in each cluster
+void buildPathfindingClusters(const Pathfinding& from, PathfindingClusters& result, unsigned clusterSize);
 
 #endif
\ No newline at end of file
@@ -25,7 +25,8 @@ DisplayListSettings::DisplayListSettings():
     mTicksPerSecond(30),
     mExportAnimation(true),
     mExportGeometry(true),
-    mIncludeCulling(true) {
+    mIncludeCulling(true),
+    mThreadCount(1) {
 }
 
 std::vector<SKAnimationHeader> generateAnimationData(const aiScene* scene, BoneHierarchy& bones, CFileDefinition& fileDef, float modelScale, unsigned short targetTicksPerSecond, aiQuaternion rotate, std::ostream& output, std::ostream& animationDef) {
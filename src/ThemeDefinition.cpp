@@ -3,6 +3,7 @@
 #include "yaml-cpp/yaml.h"
 #include <fstream>
 #include <iostream>
+#include <math.h>
 #include "StringUtils.h"
 #include "FileUtils.h"
 
@@ -15,6 +16,141 @@ void parseLevelThemeDefintionFromYaml(const YAML::Node& node, const std::string&
     
     output.mMaxPlayers = atoi(node["MaxPlayers"].Scalar().c_str());
 
+    if (node["PathfindingWeldDistance"].IsDefined()) {
+        output.mSettings.mPathfindingWeldDistance = (float)atof(node["PathfindingWeldDistance"].Scalar().c_str());
+    }
+
+    if (node["PathfindingClusterSize"].IsDefined()) {
+        output.mSettings.mPathfindingClusterSize = atoi(node["PathfindingClusterSize"].Scalar().c_str());
+    }
+
+    if (node["PathfindingSimplifyTolerance"].IsDefined()) {
+        output.mSettings.mPathfindingSimplifyTolerance = (float)atof(node["PathfindingSimplifyTolerance"].Scalar().c_str());
+    }
+
+    if (node["NextNodeTable"].IsDefined()) {
+        output.mSettings.mPathfindingNextNodeTable = node["NextNodeTable"].as<bool>();
+    }
+
+    if (node["ExportNavGraph"].IsDefined()) {
+        output.mSettings.mExportNavGraph = node["ExportNavGraph"].as<bool>();
+    }
+
+    if (node["BoundarySimplifyTolerance"].IsDefined()) {
+        output.mSettings.mBoundarySimplifyTolerance = (float)atof(node["BoundarySimplifyTolerance"].Scalar().c_str());
+    }
+
+    if (node["BoundaryDistanceCellSize"].IsDefined()) {
+        output.mSettings.mBoundaryDistanceCellSize = (float)atof(node["BoundaryDistanceCellSize"].Scalar().c_str());
+    }
+
+    if (node["BoundaryDistanceBits"].IsDefined()) {
+        unsigned bits = node["BoundaryDistanceBits"].as<unsigned>();
+
+        if (bits == 8 || bits == 16) {
+            output.mSettings.mBoundaryDistanceBits = bits;
+        } else {
+            std::cerr << "BoundaryDistanceBits should be 8 or 16 not " << bits << std::endl;
+        }
+    }
+
+    if (node["BoundaryGridCellSize"].IsDefined()) {
+        output.mSettings.mBoundaryGridCellSize = (float)atof(node["BoundaryGridCellSize"].Scalar().c_str());
+    }
+
+    if (node["FlowFieldCellSize"].IsDefined()) {
+        output.mSettings.mFlowFieldCellSize = (float)atof(node["FlowFieldCellSize"].Scalar().c_str());
+    }
+
+    if (node["HeightfieldCellSize"].IsDefined()) {
+        output.mSettings.mHeightfieldCellSize = (float)atof(node["HeightfieldCellSize"].Scalar().c_str());
+    }
+
+    if (node["HeightfieldNormals"].IsDefined()) {
+        output.mSettings.mHeightfieldNormals = node["HeightfieldNormals"].as<bool>();
+    }
+
+    if (node["OccupancyCellSize"].IsDefined()) {
+        output.mSettings.mOccupancyCellSize = (float)atof(node["OccupancyCellSize"].Scalar().c_str());
+    }
+
+    if (node["OccupancyBaseRadius"].IsDefined()) {
+        output.mSettings.mOccupancyBaseRadius = (float)atof(node["OccupancyBaseRadius"].Scalar().c_str());
+    }
+
+    if (node["CameraConeCulling"].IsDefined()) {
+        output.mSettings.mCameraConeCulling = node["CameraConeCulling"].as<bool>();
+    }
+
+    if (node["CameraConeAngle"].IsDefined()) {
+        output.mSettings.mCameraConeAngle = (float)atof(node["CameraConeAngle"].Scalar().c_str()) * M_PI / 180.0f;
+    }
+
+    if (node["CameraDirection"].IsDefined() && node["CameraDirection"].size() == 3) {
+        const YAML::Node& direction = node["CameraDirection"];
+        output.mSettings.mCameraDirection = aiVector3D(
+            (float)atof(direction[0].Scalar().c_str()),
+            (float)atof(direction[1].Scalar().c_str()),
+            (float)atof(direction[2].Scalar().c_str())
+        );
+    }
+
+    if (node["CameraOcclusionCulling"].IsDefined()) {
+        output.mSettings.mCameraOcclusionCulling = node["CameraOcclusionCulling"].as<bool>();
+    }
+
+    if (node["BakeDecorMatrices"].IsDefined()) {
+        output.mSettings.mBakeDecorMatrices = node["BakeDecorMatrices"].as<bool>();
+    }
+
+    if (node["MergeMaterials"].IsDefined()) {
+        output.mSettings.mMergeGeometryMaterials = node["MergeMaterials"].as<bool>();
+    }
+
+    if (node["BspOrdering"].IsDefined()) {
+        output.mSettings.mBspOrdering = node["BspOrdering"].as<bool>();
+    }
+
+    if (node["BspMaxSplits"].IsDefined()) {
+        output.mSettings.mBspMaxSplits = node["BspMaxSplits"].as<unsigned>();
+    }
+
+    if (node["TileSize"].IsDefined()) {
+        output.mSettings.mTileSize = (float)atof(node["TileSize"].Scalar().c_str());
+    }
+
+    if (node["PvsCellSize"].IsDefined()) {
+        output.mSettings.mPvsCellSize = (float)atof(node["PvsCellSize"].Scalar().c_str());
+    }
+
+    if (node["PvsEyeHeight"].IsDefined()) {
+        output.mSettings.mPvsEyeHeight = (float)atof(node["PvsEyeHeight"].Scalar().c_str());
+    }
+
+    if (node["CollisionBVH"].IsDefined()) {
+        output.mSettings.mExportCollisionBVH = node["CollisionBVH"].as<bool>();
+    }
+
+    if (node["LineOfSight"].IsDefined()) {
+        output.mSettings.mLineOfSight = node["LineOfSight"].as<bool>();
+    }
+
+    if (node["BaseDistanceFields"].IsDefined()) {
+        output.mSettings.mPathfindingBaseDistanceFields = node["BaseDistanceFields"].as<bool>();
+    }
+
+    if (node["NextNodeCompression"].IsDefined()) {
+        std::string compression = node["NextNodeCompression"].Scalar();
+
+        if (compression == "Rows") {
+            output.mSettings.mNextNodeCompression = NextNodeCompression::Rows;
+        } else if (compression == "RunLength") {
+            output.mSettings.mNextNodeCompression = NextNodeCompression::RunLength;
+        } else if (compression != "None") {
+            std::cerr << "Unknown NextNodeCompression '" << compression << "' for level " << output.mName << std::endl;
+        }
+    }
+
     if (node["Campaign"].IsDefined()) {
         output.mFlags.push_back("LevelMetadataFlagsCampaign");
     }
@@ -33,11 +169,23 @@ void parseSingleThemeDefinitionFromYaml(const YAML::Node& node, const std::strin
     output.mCName = output.mName;
     makeCCompatible(output.mCName);
     output.mOutput = Join(relativeDir, node["Output"].Scalar());
+    output.mCollisionSimplifyTolerance = 0.0f;
+
+    if (node["CollisionSimplifyTolerance"].IsDefined()) {
+        output.mCollisionSimplifyTolerance = (float)atof(node["CollisionSimplifyTolerance"].Scalar().c_str());
+    }
+
+    output.mConvexCollision = false;
+
+    if (node["ConvexCollision"].IsDefined()) {
+        output.mConvexCollision = node["ConvexCollision"].as<bool>();
+    }
 
     const YAML::Node& levels = node["Levels"];
 
     for (unsigned i = 0; i < levels.size(); ++i) {
         LevelThemeDefinition level;
+        level.mSettings.mBoundarySimplifyTolerance = output.mCollisionSimplifyTolerance;
         parseLevelThemeDefintionFromYaml(levels[i], relativeDir, level);
         output.mLevels.push_back(level);
     }
@@ -3,6 +3,7 @@
 
 #include <string>
 #include <vector>
+#include "LevelSettings.h"
 
 class LevelThemeDefinition {
 public:
@@ -11,6 +12,7 @@ public:
     std::string mFilename;
     std::string mOutput;
     unsigned mMaxPlayers;
+    LevelSettings mSettings;
     
     std::vector<std::string> mFlags;
 };
@@ -20,6 +22,10 @@ public:
     std::string mName;
     std::string mCName;
     std::string mOutput;
+    // decor collision and level boundaries are simplified up to this distance
+    float mCollisionSimplifyTolerance;
+    // concave decor collision is written as a compound of convex pieces
+    bool mConvexCollision;
 
     std::vector<LevelThemeDefinition> mLevels;
 };
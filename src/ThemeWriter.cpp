@@ -4,6 +4,7 @@
 #include <fstream>
 #include <sstream>
 #include <algorithm>
+#include <iostream>
 #include "SceneLoader.h"
 #include "LevelWriter.h"
 #include "FileUtils.h"
@@ -17,7 +18,7 @@ ThemeMesh::ThemeMesh(): mesh(nullptr), wireMesh(nullptr), index(0) {
 
 }
 
-ThemeWriter::ThemeWriter(const std::string& themeName, const std::string& themeHeader) : mThemeName(themeName), mThemeHeader(themeHeader) {
+ThemeWriter::ThemeWriter(const std::string& themeName, const std::string& themeHeader) : mCollisionSimplifyTolerance(0.0f), mConvexCollision(false), mThemeName(themeName), mThemeHeader(themeHeader) {
     
 }
 
@@ -111,6 +112,10 @@ void ThemeWriter::AppendContentFromScene(const aiScene* scene, DisplayListSettin
                 extractMeshBoundary(mesh, worldTransform, themeMesh.boundary);
                 mDecorMeshes[decorName] = themeMesh;
             } else {
+                if (existing->second.boundary.size()) {
+                    std::cerr << "Decor " << decorName << " has more than one collision mesh, only the outline of " << mesh->mName.C_Str() << " is used" << std::endl;
+                }
+
                 extractMeshBoundary(mesh, worldTransform, existing->second.boundary);
             }
         } else if (GetDecorWireName(mesh->mName.C_Str(), decorName)) {
@@ -260,9 +265,61 @@ std::string writeGeometry(std::ostream& cfile, std::vector<ThemeMesh*>& meshList
     return decorDisplayLists;
 }
 
-std::string writeCollision(std::ostream& cfile, std::vector<ThemeMesh*>& meshList, CFileDefinition& fileDef, DisplayListSettings& settings) {
+std::string writeCollisionPolygon(std::ostream& cfile, const std::string& name, const std::vector<aiVector3D>& boundary, CFileDefinition& fileDef) {
+    std::string colliderName = fileDef.GetUniqueName(name);
+    std::string colliderEdges = fileDef.GetUniqueName(name + "Edges");
+
+    cfile << "struct CollisionPolygonEdge " << colliderEdges << "[] = {" << std::endl;
+
+    unsigned actualEdgeCount = 0;
+
+    for (unsigned i = 0; i < boundary.size(); ++i) {
+        aiVector3D curr = boundary[i];
+        aiVector3D edge = boundary[(i + 1) % boundary.size()] - curr;
+
+        if (edge.SquareLength() < 0.001f) {
+            continue;
+        }
+
+        curr.y = 0.0f;
+        edge.y = 0.0f;
+
+        aiVector3D normal = edge;
+        normal.Normalize();
+
+        cfile << "    {";
+        cfile << "{" << curr.x << ", " << curr.z << "}, ";
+        cfile << "{" << normal.z << ", " << -normal.x << "}, ";
+        cfile << edge.Length();
+        cfile << "}," << std::endl;
+
+        ++actualEdgeCount;
+    }
+
+    cfile << "};" << std::endl;
+
+    cfile << "struct CollisionPolygon " << colliderName << " = {" << std::endl;
+    cfile << "    .shapeCommon = {CollisionShapeTypePolygon}," << std::endl;
+    cfile << "    .edges = " << colliderEdges << "," << std::endl;
+    cfile << "    .edgeCount = " << actualEdgeCount << "," << std::endl;
+    cfile << "};" << std::endl;
+
+    return colliderName;
+}
+
+std::string writeCollision(std::ostream& cfile, std::vector<ThemeMesh*>& meshList, CFileDefinition& fileDef, DisplayListSettings& settings, float simplifyTolerance, bool convexDecomposition) {
     std::string decorShapes = fileDef.GetUniqueName("DecorShapes");
 
+    if (simplifyTolerance > 0.0f) {
+        unsigned removedEdges = 0;
+
+        for (auto mesh : meshList) {
+            removedEdges += simplifyBoundary(mesh->boundary, simplifyTolerance, false);
+        }
+
+        std::cout << "Simplifying decor collision removed " << removedEdges << " edges" << std::endl;
+    }
+
     std::vector<std::string> displayListNames;
     
     for (auto mesh : meshList) {
@@ -278,53 +335,56 @@ std::string writeCollision(std::ostream& cfile, std::vector<ThemeMesh*>& meshLis
 
             displayListNames.push_back("(struct CollisionShape*)&" + colliderName);
         } else if (mesh->boundary.size()) {
-            std::string colliderName = fileDef.GetUniqueName(mesh->objectName + "Shape");
-            std::string colliderEdges = fileDef.GetUniqueName(mesh->objectName + "ShapeEdges");
+            std::vector<std::vector<aiVector3D>> convexPieces;
 
-            cfile << "struct CollisionPolygonEdge " << colliderEdges << "[] = {" << std::endl;
+            if (convexDecomposition) {
+                decomposeConvex(mesh->boundary, convexPieces);
+            }
 
-            aiVector3D min = mesh->boundary[0];
-            aiVector3D max = mesh->boundary[0];
+            if (convexPieces.size() > 1) {
+                std::vector<std::string> pieceNames;
 
-            unsigned actualEdgeCount = 0;
+                for (auto& piece : convexPieces) {
+                    pieceNames.push_back(writeCollisionPolygon(cfile, mesh->objectName + "Piece", piece, fileDef));
+                }
 
-            for (unsigned i = 0; i < mesh->boundary.size(); ++i) {
-                aiVector3D curr = mesh->boundary[i];
-                aiVector3D edge = mesh->boundary[(i + 1) % mesh->boundary.size()] - curr;
+                std::string colliderName = fileDef.GetUniqueName(mesh->objectName + "Shape");
+                std::string colliderParts = fileDef.GetUniqueName(mesh->objectName + "ShapeParts");
 
-                if (edge.SquareLength() < 0.001f) {
-                    continue;
-                }
+                cfile << "struct CollisionCompoundPart " << colliderParts << "[] = {" << std::endl;
 
-                curr.y = 0.0f;
-                edge.y = 0.0f;
+                for (unsigned i = 0; i < convexPieces.size(); ++i) {
+                    aiVector3D center;
 
-                aiVector3D normal = edge;
-                normal.Normalize();
+                    for (auto& point : convexPieces[i]) {
+                        center += point;
+                    }
 
-                cfile << "    {";
-                cfile << "{" << curr.x << ", " << curr.z << "}, ";
-                cfile << "{" << normal.z << ", " << -normal.x << "}, ";
-                cfile << edge.Length();
-                cfile << "}," << std::endl;
+                    center /= (float)convexPieces[i].size();
+                    center.y = 0.0f;
 
-                min.x = std::min(min.x, curr.x);
-                min.z = std::min(min.z, curr.z);
-                max.x = std::max(max.x, curr.x);
-                max.z = std::max(max.z, curr.z);
+                    float radius = 0.0f;
 
-                ++actualEdgeCount;
-            }
+                    for (auto point : convexPieces[i]) {
+                        point.y = 0.0f;
+                        radius = std::max(radius, (point - center).Length());
+                    }
 
-            cfile << "};" << std::endl;
+                    cfile << "    {{" << center.x << ", " << center.z << "}, " << radius << ", (struct CollisionShape*)&" << pieceNames[i] << "}," << std::endl;
+                }
 
-            cfile << "struct CollisionPolygon " << colliderName << " = {" << std::endl;
-            cfile << "    .shapeCommon = {CollisionShapeTypePolygon}," << std::endl;
-            cfile << "    .edges = " << colliderEdges << "," << std::endl;
-            cfile << "    .edgeCount = " << actualEdgeCount << "," << std::endl;
-            cfile << "};" << std::endl;
+                cfile << "};" << std::endl;
 
-            displayListNames.push_back("(struct CollisionShape*)&" + colliderName);
+                cfile << "struct CollisionCompound " << colliderName << " = {" << std::endl;
+                cfile << "    .shapeCommon = {CollisionShapeTypeCompound}," << std::endl;
+                cfile << "    .parts = " << colliderParts << "," << std::endl;
+                cfile << "    .partCount = " << convexPieces.size() << "," << std::endl;
+                cfile << "};" << std::endl;
+
+                displayListNames.push_back("(struct CollisionShape*)&" + colliderName);
+            } else {
+                displayListNames.push_back("(struct CollisionShape*)&" + writeCollisionPolygon(cfile, mesh->objectName + "Shape", mesh->boundary, fileDef));
+            }
         } else {
             displayListNames.push_back("0");
         }
@@ -363,7 +423,7 @@ void ThemeWriter::WriteTheme(const std::string& output, DisplayListSettings& set
 
     std::string decorMaterials = WriteMaterials(cfile, meshList, fileDef, settings);
     std::string decorDisplayLists = writeGeometry(cfile, meshList, mDecorGeoNames, fileDef, settings);
-    std::string decorShapes = writeCollision(cfile, meshList, fileDef, settings);
+    std::string decorShapes = writeCollision(cfile, meshList, fileDef, settings, mCollisionSimplifyTolerance, mConvexCollision);
 
     cfile << "struct ThemeDefinition " << mThemeName << "Theme = {" << std::endl;
     cfile << "    .decorMaterials = " << decorMaterials << "," << std::endl;
@@ -446,8 +506,21 @@ std::string ThemeWriter::GetDecorGeo(const std::string& decorName) {
     return mDecorGeoNames[mesh->second.index];
 }
 
+bool ThemeWriter::GetDecorBoundary(const std::string& decorName, std::vector<aiVector3D>& output) {
+    auto mesh = mDecorMeshes.find(decorName);
+
+    if (mesh == mDecorMeshes.end()) {
+        return false;
+    }
+
+    output = mesh->second.boundary;
+    return true;
+}
+
 void generateThemeDefiniton(ThemeDefinition& themeDef, DisplayListSettings& settings) {
     ThemeWriter themeWriter(themeDef.mCName, replaceExtension(themeDef.mOutput, ".h"));
+    themeWriter.mCollisionSimplifyTolerance = themeDef.mCollisionSimplifyTolerance;
+    themeWriter.mConvexCollision = themeDef.mConvexCollision;
     std::vector<LevelTheme> levels;
 
     // force the materials to be written in the theme
@@ -476,6 +549,7 @@ void generateThemeDefiniton(ThemeDefinition& themeDef, DisplayListSettings& sett
     for (auto it = levels.begin(); it != levels.end(); ++it) {
         DisplayListSettings levelSettings = settings;
         levelSettings.mPrefix = it->definition.mCName;
+        levelSettings.mLevelSettings = it->definition.mSettings;
         std::cout << "Saving level to " << it->definition.mOutput << std::endl;
         generateLevelFromSceneToFile(it->scene, it->definition.mOutput, &themeWriter, levelSettings);
     }
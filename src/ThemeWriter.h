@@ -40,7 +40,10 @@ public:
     const std::string& GetThemeName() const;
     std::string GetDecorMaterial(const std::string& decorName);
     std::string GetDecorGeo(const std::string& decorName); 
+    bool GetDecorBoundary(const std::string& decorName, std::vector<aiVector3D>& output);
     MaterialCollector mMaterialCollector;
+    float mCollisionSimplifyTolerance;
+    bool mConvexCollision;
 private:
     std::string WriteMaterials(std::ostream& cfile, std::vector<ThemeMesh*>& meshList, CFileDefinition& fileDef, DisplayListSettings& settings);
     void AppendContentFromNode(const aiScene* scene, const aiNode* node, DisplayListSettings& settings);
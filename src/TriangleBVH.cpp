@@ -0,0 +1,183 @@
+#include "TriangleBVH.h"
+
+#include <algorithm>
+#include <limits>
+#include <math.h>
+
+void buildTriangleBVHNode(const std::vector<aiVector3D>& triangles, std::vector<unsigned>& triangleOrder, unsigned start, unsigned end, TriangleBVH& result) {
+    unsigned nodeIndex = result.mNodes.size();
+    result.mNodes.push_back(TriangleBVHNode());
+
+    aiVector3D min = triangles[triangleOrder[start] * 3];
+    aiVector3D max = min;
+    aiVector3D centerMin(std::numeric_limits<float>::max());
+    aiVector3D centerMax(-std::numeric_limits<float>::max());
+
+    for (unsigned i = start; i < end; ++i) {
+        aiVector3D center;
+
+        for (unsigned corner = 0; corner < 3; ++corner) {
+            const aiVector3D& point = triangles[triangleOrder[i] * 3 + corner];
+            min.x = std::min(min.x, point.x); min.y = std::min(min.y, point.y); min.z = std::min(min.z, point.z);
+            max.x = std::max(max.x, point.x); max.y = std::max(max.y, point.y); max.z = std::max(max.z, point.z);
+            center += point;
+        }
+
+        center /= 3.0f;
+        centerMin.x = std::min(centerMin.x, center.x); centerMin.y = std::min(centerMin.y, center.y); centerMin.z = std::min(centerMin.z, center.z);
+        centerMax.x = std::max(centerMax.x, center.x); centerMax.y = std::max(centerMax.y, center.y); centerMax.z = std::max(centerMax.z, center.z);
+    }
+
+    result.mNodes[nodeIndex].mMin = min;
+    result.mNodes[nodeIndex].mMax = max;
+
+    if (end - start <= BVH_MAX_LEAF_TRIANGLES) {
+        result.mNodes[nodeIndex].mChildOrFirstTriangle = result.mTriangles.size() / 3;
+        result.mNodes[nodeIndex].mTriangleCount = end - start;
+
+        for (unsigned i = start; i < end; ++i) {
+            for (unsigned corner = 0; corner < 3; ++corner) {
+                result.mTriangles.push_back(triangles[triangleOrder[i] * 3 + corner]);
+            }
+        }
+
+        return;
+    }
+
+    // split at the median center along the longest axis
+    aiVector3D extent = centerMax - centerMin;
+    unsigned axis = 0;
+
+    if (extent.y > extent[axis]) {
+        axis = 1;
+    }
+
+    if (extent.z > extent[axis]) {
+        axis = 2;
+    }
+
+    unsigned middle = (start + end) / 2;
+
+    std::nth_element(triangleOrder.begin() + start, triangleOrder.begin() + middle, triangleOrder.begin() + end, [&](unsigned a, unsigned b) -> bool {
+        return triangles[a * 3][axis] + triangles[a * 3 + 1][axis] + triangles[a * 3 + 2][axis] <
+            triangles[b * 3][axis] + triangles[b * 3 + 1][axis] + triangles[b * 3 + 2][axis];
+    });
+
+    buildTriangleBVHNode(triangles, triangleOrder, start, middle, result);
+    result.mNodes[nodeIndex].mChildOrFirstTriangle = result.mNodes.size();
+    result.mNodes[nodeIndex].mTriangleCount = 0;
+    buildTriangleBVHNode(triangles, triangleOrder, middle, end, result);
+}
+
+void buildTriangleBVH(const std::vector<aiVector3D>& triangles, TriangleBVH& result) {
+    result.mNodes.clear();
+    result.mTriangles.clear();
+
+    unsigned triangleCount = triangles.size() / 3;
+
+    if (triangleCount == 0) {
+        return;
+    }
+
+    std::vector<unsigned> triangleOrder(triangleCount);
+
+    for (unsigned i = 0; i < triangleCount; ++i) {
+        triangleOrder[i] = i;
+    }
+
+    buildTriangleBVHNode(triangles, triangleOrder, 0, triangleCount, result);
+}
+
+bool doesSegmentHitBox(const aiVector3D& from, const aiVector3D& offset, const aiVector3D& min, const aiVector3D& max) {
+    float enter = 0.0f;
+    float exit = 1.0f;
+
+    for (unsigned axis = 0; axis < 3; ++axis) {
+        if (fabsf(offset[axis]) < 0.000001f) {
+            if (from[axis] < min[axis] || from[axis] > max[axis]) {
+                return false;
+            }
+
+            continue;
+        }
+
+        float minT = (min[axis] - from[axis]) / offset[axis];
+        float maxT = (max[axis] - from[axis]) / offset[axis];
+
+        if (minT > maxT) {
+            std::swap(minT, maxT);
+        }
+
+        enter = std::max(enter, minT);
+        exit = std::min(exit, maxT);
+
+        if (enter > exit) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// moller trumbore, returns the distance along offset or a value past 1 when there is no hit
+float segmentTriangleDistance(const aiVector3D& from, const aiVector3D& offset, const aiVector3D& a, const aiVector3D& b, const aiVector3D& c) {
+    aiVector3D edgeA = b - a;
+    aiVector3D edgeB = c - a;
+    aiVector3D p = offset ^ edgeB;
+    float determinant = edgeA * p;
+
+    if (fabsf(determinant) < 0.0000001f) {
+        return 2.0f;
+    }
+
+    aiVector3D relative = from - a;
+    float u = (relative * p) / determinant;
+
+    if (u < 0.0f || u > 1.0f) {
+        return 2.0f;
+    }
+
+    aiVector3D q = relative ^ edgeA;
+    float v = (offset * q) / determinant;
+
+    if (v < 0.0f || u + v > 1.0f) {
+        return 2.0f;
+    }
+
+    float distance = (edgeB * q) / determinant;
+    return distance < 0.0f ? 2.0f : distance;
+}
+
+bool TriangleBVH::IsSegmentBlocked(const aiVector3D& from, const aiVector3D& to) const {
+    if (mNodes.empty()) {
+        return false;
+    }
+
+    aiVector3D offset = to - from;
+    std::vector<unsigned> stack;
+    stack.push_back(0);
+
+    while (stack.size()) {
+        const TriangleBVHNode& node = mNodes[stack.back()];
+        unsigned nodeIndex = stack.back();
+        stack.pop_back();
+
+        if (!doesSegmentHitBox(from, offset, node.mMin, node.mMax)) {
+            continue;
+        }
+
+        if (node.mTriangleCount == 0) {
+            stack.push_back(nodeIndex + 1);
+            stack.push_back(node.mChildOrFirstTriangle);
+            continue;
+        }
+
+        for (unsigned i = node.mChildOrFirstTriangle; i < node.mChildOrFirstTriangle + node.mTriangleCount; ++i) {
+            if (segmentTriangleDistance(from, offset, mTriangles[i * 3], mTriangles[i * 3 + 1], mTriangles[i * 3 + 2]) < 0.999f) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,34 @@
+#ifndef _TRIANGLE_BVH_H
+#define _TRIANGLE_BVH_H
+
+#include <assimp/mesh.h>
+#include <vector>
+
+#define BVH_MAX_LEAF_TRIANGLES  4
+
+class TriangleBVHNode {
+public:
+    aiVector3D mMin;
+    aiVector3D mMax;
+    // for leaves the first triangle, otherwise the index of the second child
+    // the first child of a node always directly follows it
+    unsigned mChildOrFirstTriangle;
+    // 0 for nodes that aren't leaves
+    unsigned mTriangleCount;
+};
+
+class TriangleBVH {
+public:
+    // nodes in depth first order
+    std::vector<TriangleBVHNode> mNodes;
+    // three points per triangle ordered so each leaf references a contiguous range
+    std::vector<aiVector3D> mTriangles;
+
+    // checks if any triangle is hit between from and to, not counting hits right at to
+    bool IsSegmentBlocked(const aiVector3D& from, const aiVector3D& to) const;
+};
+
+// triangles should contain three points per triangle
+void buildTriangleBVH(const std::vector<aiVector3D>& triangles, TriangleBVH& result);
+
+#endif
@@ -0,0 +1,75 @@
+#include "../src/BspTree.h"
+
+#include "TestUtil.h"
+
+aiMesh* createTriangleMesh(const aiVector3D& a, const aiVector3D& b, const aiVector3D& c) {
+    aiMesh* result = new aiMesh();
+    result->mNumVertices = 3;
+    result->mVertices = new aiVector3D[3];
+    result->mVertices[0] = a;
+    result->mVertices[1] = b;
+    result->mVertices[2] = c;
+
+    result->mNumFaces = 1;
+    result->mFaces = new aiFace[1];
+    result->mFaces[0].mNumIndices = 3;
+    result->mFaces[0].mIndices = new unsigned[3];
+
+    for (unsigned i = 0; i < 3; ++i) {
+        result->mFaces[0].mIndices[i] = i;
+    }
+
+    return result;
+}
+
+// far from the origin the splitter used to land off its own plane
+// and the same node was built over and over
+void testLargeOffOriginTriangle() {
+    aiMesh* mesh = createTriangleMesh(
+        aiVector3D(14793.5f, 6777.5f, 15383.6f),
+        aiVector3D(13362.7f, 5649.1f, 12386.2f),
+        aiVector3D(16540.6f, 6763.6f, 18690.9f)
+    );
+
+    BspTree tree;
+    CHECK(buildBspTree({mesh}, 16, tree));
+    CHECK(tree.mNodes.size() == 1);
+    CHECK(tree.mSplitCount == 0);
+    CHECK(tree.mNodes.size() == 1 && tree.mNodes[0].mFront == -1 && tree.mNodes[0].mBack == -1);
+
+    for (auto& node : tree.mNodes) {
+        for (auto nodeMesh : node.mMeshes) {
+            delete nodeMesh;
+        }
+    }
+
+    delete mesh;
+}
+
+void testSplitBudget() {
+    aiMesh* floor = createTriangleMesh(aiVector3D(-1.0f, 0.0f, -1.0f), aiVector3D(-1.0f, 0.0f, 1.0f), aiVector3D(1.0f, 0.0f, 0.0f));
+    aiMesh* wall = createTriangleMesh(aiVector3D(0.0f, -1.0f, -1.0f), aiVector3D(0.0f, 1.0f, 0.0f), aiVector3D(0.0f, -1.0f, 1.0f));
+
+    BspTree tree;
+    CHECK(!buildBspTree({floor, wall}, 0, tree));
+    CHECK(tree.mNodes.empty());
+
+    CHECK(buildBspTree({floor, wall}, 16, tree));
+    CHECK(tree.mSplitCount == 1);
+
+    for (auto& node : tree.mNodes) {
+        for (auto nodeMesh : node.mMeshes) {
+            delete nodeMesh;
+        }
+    }
+
+    delete floor;
+    delete wall;
+}
+
+int main() {
+    testLargeOffOriginTriangle();
+    testSplitBudget();
+
+    return gFailures ? 1 : 0;
+}
@@ -0,0 +1,54 @@
+#include "../src/Collision.h"
+
+#include "TestUtil.h"
+#include <math.h>
+
+// a jagged counter clockwise star with sharp spikes
+void createStar(std::vector<aiVector3D>& boundary) {
+    for (unsigned i = 0; i < 40; ++i) {
+        float angle = i * 2.0f * (float)M_PI / 40.0f;
+        float radius = 10.0f + (i % 2 ? 0.3f : 0.0f) + (i % 5 == 0 ? 4.0f : 0.0f);
+        boundary.push_back(aiVector3D(cosf(angle) * radius, 0.0f, sinf(angle) * radius));
+    }
+}
+
+void testSimplifiedBoundaryContainsOriginal() {
+    std::vector<aiVector3D> boundary;
+    createStar(boundary);
+
+    std::vector<aiVector3D> simplified = boundary;
+    simplifyBoundary(simplified, 0.5f, false);
+
+    for (auto& point : boundary) {
+        CHECK(signedDistanceToBoundary(point, simplified) > -0.001f);
+    }
+
+    for (unsigned i = 0; i < boundary.size(); ++i) {
+        aiVector3D middle = (boundary[i] + boundary[(i + 1) % boundary.size()]) * 0.5f;
+        CHECK(signedDistanceToBoundary(middle, simplified) > -0.001f);
+    }
+}
+
+void testShrunkBoundaryInsideOriginal() {
+    std::vector<aiVector3D> boundary;
+    createStar(boundary);
+
+    std::vector<aiVector3D> simplified = boundary;
+    CHECK(simplifyBoundary(simplified, 0.5f, true) > 0);
+
+    for (auto& point : simplified) {
+        CHECK(signedDistanceToBoundary(point, boundary) > -0.001f);
+    }
+
+    for (unsigned i = 0; i < simplified.size(); ++i) {
+        aiVector3D middle = (simplified[i] + simplified[(i + 1) % simplified.size()]) * 0.5f;
+        CHECK(signedDistanceToBoundary(middle, boundary) > -0.001f);
+    }
+}
+
+int main() {
+    testSimplifiedBoundaryContainsOriginal();
+    testShrunkBoundaryInsideOriginal();
+
+    return gFailures ? 1 : 0;
+}
@@ -0,0 +1,35 @@
+#include "../src/Heightfield.h"
+
+#include "TestUtil.h"
+#include <math.h>
+
+// a ramp rising one unit for each unit along z
+void testSamplesRampHeight() {
+    std::vector<aiVector3D> triangles = {
+        aiVector3D(0.0f, 2.0f, 0.0f),
+        aiVector3D(10.0f, 2.0f, 0.0f),
+        aiVector3D(0.0f, 12.0f, 10.0f),
+    };
+
+    Heightfield heightfield;
+    buildHeightfield(triangles, aiVector3D(0.0f, 0.0f, 0.0f), aiVector3D(10.0f, 0.0f, 10.0f), 1.0f, true, heightfield);
+
+    CHECK(heightfield.mWidth == 11);
+    CHECK(heightfield.mHeight == 11);
+    CHECK(fabsf(heightfield.mHeights[5 * heightfield.mWidth + 0] - 7.0f) < 0.001f);
+    CHECK(fabsf(heightfield.mHeights[4 * heightfield.mWidth + 2] - 6.0f) < 0.001f);
+
+    // outside of the triangle falls back to the lowest height
+    CHECK(fabsf(heightfield.mHeights[9 * heightfield.mWidth + 9] - 2.0f) < 0.001f);
+
+    const aiVector3D& normal = heightfield.mNormals[4 * heightfield.mWidth + 2];
+    CHECK(fabsf(normal.x) < 0.001f);
+    CHECK(fabsf(normal.y - sqrtf(0.5f)) < 0.001f);
+    CHECK(fabsf(normal.z + sqrtf(0.5f)) < 0.001f);
+}
+
+int main() {
+    testSamplesRampHeight();
+
+    return gFailures ? 1 : 0;
+}
@@ -0,0 +1,280 @@
+#include "../src/Pathfinding.h"
+
+#include "TestUtil.h"
+#include <string.h>
+#include <math.h>
+
+void connect(Pathfinding& graph, unsigned a, unsigned b) {
+    graph.mNodeConnections.insert(std::make_pair(a, b));
+    graph.mNodeConnections.insert(std::make_pair(b, a));
+}
+
+// a square level with a notch cut into the top, the middle node goes
+// around the bottom of the notch and skipping it would go through the wall
+void testSimplifyKeepsNodesAroundNotch() {
+    std::vector<aiVector3D> boundary = {
+        aiVector3D(0.0f, 0.0f, 0.0f),
+        aiVector3D(10.0f, 0.0f, 0.0f),
+        aiVector3D(10.0f, 0.0f, 10.0f),
+        aiVector3D(6.0f, 0.0f, 10.0f),
+        aiVector3D(6.0f, 0.0f, 4.0f),
+        aiVector3D(4.0f, 0.0f, 4.0f),
+        aiVector3D(4.0f, 0.0f, 10.0f),
+        aiVector3D(0.0f, 0.0f, 10.0f),
+    };
+
+    Pathfinding graph;
+    graph.mPathingNodes.push_back(aiVector3D(2.0f, 0.0f, 8.0f));
+    graph.mPathingNodes.push_back(aiVector3D(5.0f, 0.0f, 2.0f));
+    graph.mPathingNodes.push_back(aiVector3D(8.0f, 0.0f, 8.0f));
+    connect(graph, 0, 1);
+    connect(graph, 1, 2);
+
+    // the tolerance is large enough to skip the middle node if the boundary were ignored
+    simplifyPathing(graph, boundary, {}, {graph.mPathingNodes[0], graph.mPathingNodes[2]}, 100.0f);
+
+    CHECK(graph.mPathingNodes.size() == 3);
+    CHECK(graph.mNodeConnections.count(std::make_pair(0u, 2u)) == 0);
+}
+
+void testSimplifyRemovesNodeWithClearShortcut() {
+    std::vector<aiVector3D> boundary = {
+        aiVector3D(0.0f, 0.0f, 0.0f),
+        aiVector3D(10.0f, 0.0f, 0.0f),
+        aiVector3D(10.0f, 0.0f, 10.0f),
+        aiVector3D(0.0f, 0.0f, 10.0f),
+    };
+
+    Pathfinding graph;
+    graph.mPathingNodes.push_back(aiVector3D(2.0f, 0.0f, 8.0f));
+    graph.mPathingNodes.push_back(aiVector3D(5.0f, 0.0f, 2.0f));
+    graph.mPathingNodes.push_back(aiVector3D(8.0f, 0.0f, 8.0f));
+    connect(graph, 0, 1);
+    connect(graph, 1, 2);
+
+    simplifyPathing(graph, boundary, {}, {graph.mPathingNodes[0], graph.mPathingNodes[2]}, 10.0f);
+
+    CHECK(graph.mPathingNodes.size() == 2);
+}
+
+void testSimplifyKeepsNodeOutsideTolerance() {
+    std::vector<aiVector3D> boundary = {
+        aiVector3D(0.0f, 0.0f, 0.0f),
+        aiVector3D(10.0f, 0.0f, 0.0f),
+        aiVector3D(10.0f, 0.0f, 10.0f),
+        aiVector3D(0.0f, 0.0f, 10.0f),
+    };
+
+    Pathfinding graph;
+    graph.mPathingNodes.push_back(aiVector3D(2.0f, 0.0f, 8.0f));
+    graph.mPathingNodes.push_back(aiVector3D(5.0f, 0.0f, 2.0f));
+    graph.mPathingNodes.push_back(aiVector3D(8.0f, 0.0f, 8.0f));
+    connect(graph, 0, 1);
+    connect(graph, 1, 2);
+
+    // the shortcut is clear but the middle node is 6 units away from it
+    simplifyPathing(graph, boundary, {}, {graph.mPathingNodes[0], graph.mPathingNodes[2]}, 1.0f);
+
+    CHECK(graph.mPathingNodes.size() == 3);
+}
+
+void testSimplifyKeepsNodesAroundObstacle() {
+    std::vector<aiVector3D> boundary = {
+        aiVector3D(0.0f, 0.0f, 0.0f),
+        aiVector3D(10.0f, 0.0f, 0.0f),
+        aiVector3D(10.0f, 0.0f, 10.0f),
+        aiVector3D(0.0f, 0.0f, 10.0f),
+    };
+
+    std::vector<std::vector<aiVector3D>> obstacles = {{
+        aiVector3D(4.0f, 0.0f, 4.0f),
+        aiVector3D(6.0f, 0.0f, 4.0f),
+        aiVector3D(6.0f, 0.0f, 9.0f),
+        aiVector3D(4.0f, 0.0f, 9.0f),
+    }};
+
+    Pathfinding graph;
+    graph.mPathingNodes.push_back(aiVector3D(2.0f, 0.0f, 8.0f));
+    graph.mPathingNodes.push_back(aiVector3D(5.0f, 0.0f, 2.0f));
+    graph.mPathingNodes.push_back(aiVector3D(8.0f, 0.0f, 8.0f));
+    connect(graph, 0, 1);
+    connect(graph, 1, 2);
+
+    simplifyPathing(graph, boundary, obstacles, {graph.mPathingNodes[0], graph.mPathingNodes[2]}, 100.0f);
+
+    CHECK(graph.mPathingNodes.size() == 3);
+}
+
+// a jittered grid with some connections left out and a few one way diagonals
+// the jitter keeps any two routes from having exactly the same length
+void createTestGraph(Pathfinding& graph) {
+    unsigned width = 8;
+    unsigned height = 6;
+    unsigned seed = 12345;
+
+    auto random = [&]() -> float {
+        seed = seed * 1103515245 + 12345;
+        return ((seed >> 16) & 0x7FFF) / 32767.0f;
+    };
+
+    for (unsigned z = 0; z < height; ++z) {
+        for (unsigned x = 0; x < width; ++x) {
+            graph.mPathingNodes.push_back(aiVector3D(x * 2.0f + random() - 0.5f, 0.0f, z * 2.0f + random() - 0.5f));
+        }
+    }
+
+    for (unsigned z = 0; z < height; ++z) {
+        for (unsigned x = 0; x < width; ++x) {
+            unsigned node = z * width + x;
+
+            // full rows and the first column keep every node reachable
+            if (x + 1 < width) {
+                connect(graph, node, node + 1);
+            }
+
+            if (z + 1 < height && (x == 0 || random() < 0.6f)) {
+                connect(graph, node, node + width);
+            }
+
+            if (x + 1 < width && z + 1 < height && random() < 0.3f) {
+                graph.mNodeConnections.insert(std::make_pair(node, node + width + 1));
+            }
+        }
+    }
+
+    graph.BuildAdjacency();
+}
+
+void testThreadedNextNodeTableMatches() {
+    Pathfinding graph;
+    createTestGraph(graph);
+
+    LevelSettings settings;
+
+    PathfindingDefinition singleThreaded;
+    buildPathfindingDefinition(graph, singleThreaded, {}, settings, 1);
+
+    PathfindingDefinition multiThreaded;
+    buildPathfindingDefinition(graph, multiThreaded, {}, settings, 4);
+
+    CHECK(singleThreaded.mNextNode.size() == graph.mPathingNodes.size() * graph.mPathingNodes.size());
+    CHECK(singleThreaded.mNextNode == multiThreaded.mNextNode);
+    CHECK(memcmp(singleThreaded.mDistToNode.data(), multiThreaded.mDistToNode.data(), singleThreaded.mDistToNode.size() * sizeof(float)) == 0);
+}
+
+// floyd warshall straight from the connection set as a reference for the dijkstra searches
+void buildReferenceNextNodeTable(const Pathfinding& graph, std::vector<int>& nextNode, std::vector<float>& distance) {
+    unsigned numPoints = graph.mPathingNodes.size();
+
+    nextNode.assign(numPoints * numPoints, 0);
+    distance.assign(numPoints * numPoints, NO_PATH_DISTANCE);
+
+    for (unsigned from = 0; from < numPoints; ++from) {
+        for (unsigned to = 0; to < numPoints; ++to) {
+            nextNode[from * numPoints + to] = from;
+        }
+
+        distance[from * numPoints + from] = 0.0f;
+    }
+
+    for (auto connection : graph.mNodeConnections) {
+        unsigned index = connection.first * numPoints + connection.second;
+        distance[index] = (graph.mPathingNodes[connection.second] - graph.mPathingNodes[connection.first]).Length();
+        nextNode[index] = connection.second;
+    }
+
+    for (unsigned through = 0; through < numPoints; ++through) {
+        for (unsigned from = 0; from < numPoints; ++from) {
+            if (distance[from * numPoints + through] == NO_PATH_DISTANCE) {
+                continue;
+            }
+
+            for (unsigned to = 0; to < numPoints; ++to) {
+                if (distance[through * numPoints + to] == NO_PATH_DISTANCE) {
+                    continue;
+                }
+
+                float newDistance = distance[from * numPoints + through] + distance[through * numPoints + to];
+
+                if (newDistance < distance[from * numPoints + to]) {
+                    distance[from * numPoints + to] = newDistance;
+                    nextNode[from * numPoints + to] = nextNode[from * numPoints + through];
+                }
+            }
+        }
+    }
+}
+
+void testNextNodeTableMatchesReference() {
+    Pathfinding graph;
+    createTestGraph(graph);
+
+    LevelSettings settings;
+    PathfindingDefinition definition;
+    buildPathfindingDefinition(graph, definition, {}, settings, 1);
+
+    std::vector<int> nextNode;
+    std::vector<float> distance;
+    buildReferenceNextNodeTable(graph, nextNode, distance);
+
+    CHECK(definition.mNextNode == nextNode);
+
+    bool distancesMatch = definition.mDistToNode.size() == distance.size();
+
+    for (unsigned i = 0; distancesMatch && i < distance.size(); ++i) {
+        distancesMatch = fabsf(definition.mDistToNode[i] - distance[i]) <= 0.0001f * distance[i];
+    }
+
+    CHECK(distancesMatch);
+}
+
+bool isVisible(const PathfindingDefinition& definition, const std::vector<unsigned>& visibility, unsigned from, unsigned to) {
+    return (visibility[from * definition.VisibilityRowWords() + to / 32] >> (to % 32)) & 1;
+}
+
+// same notched square, nodes and the base sit right on the boundary
+void testLineOfSightFromBoundary() {
+    std::vector<aiVector3D> boundary = {
+        aiVector3D(0.0f, 0.0f, 0.0f),
+        aiVector3D(10.0f, 0.0f, 0.0f),
+        aiVector3D(10.0f, 0.0f, 10.0f),
+        aiVector3D(6.0f, 0.0f, 10.0f),
+        aiVector3D(6.0f, 0.0f, 4.0f),
+        aiVector3D(4.0f, 0.0f, 4.0f),
+        aiVector3D(4.0f, 0.0f, 10.0f),
+        aiVector3D(0.0f, 0.0f, 10.0f),
+    };
+
+    PathfindingDefinition definition;
+    definition.mNodePositions.push_back(aiVector3D(0.0f, 0.0f, 5.0f));
+    definition.mNodePositions.push_back(aiVector3D(2.0f, 0.0f, 8.0f));
+    definition.mNodePositions.push_back(aiVector3D(10.0f, 0.0f, 5.0f));
+    definition.mNodePositions.push_back(aiVector3D(4.0f, 0.0f, 10.0f));
+    definition.mNodePositions.push_back(aiVector3D(6.0f, 0.0f, 10.0f));
+
+    buildLineOfSight(definition, {aiVector3D(5.0f, 0.0f, 0.0f)}, boundary);
+
+    CHECK(isVisible(definition, definition.mNodeVisibility, 0, 1));
+    CHECK(isVisible(definition, definition.mNodeVisibility, 1, 0));
+    CHECK(isVisible(definition, definition.mNodeVisibility, 1, 3));
+    // through the notch
+    CHECK(!isVisible(definition, definition.mNodeVisibility, 0, 2));
+    // across the open end of the notch between two boundary corners
+    CHECK(!isVisible(definition, definition.mNodeVisibility, 3, 4));
+
+    CHECK(isVisible(definition, definition.mBaseVisibility, 0, 1));
+    CHECK(isVisible(definition, definition.mBaseVisibility, 0, 2));
+    CHECK(!isVisible(definition, definition.mBaseVisibility, 0, 4));
+}
+
+int main() {
+    testSimplifyKeepsNodesAroundNotch();
+    testSimplifyRemovesNodeWithClearShortcut();
+    testSimplifyKeepsNodeOutsideTolerance();
+    testSimplifyKeepsNodesAroundObstacle();
+    testLineOfSightFromBoundary();
+    testThreadedNextNodeTableMatches();
+    testNextNodeTableMatchesReference();
+
+    return gFailures ? 1 : 0;
+}
@@ -0,0 +1,11 @@
+#ifndef _TEST_UTIL_H
+#define _TEST_UTIL_H
+
+#include <iostream>
+
+// each test binary includes this once, main returns gFailures ? 1 : 0
+int gFailures = 0;
+
+#define CHECK(condition) if (!(condition)) { std::cerr << __FILE__ << ":" << __LINE__ << " failed: " #condition << std::endl; ++gFailures; }
+
+#endif